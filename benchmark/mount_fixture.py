@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Fake CWIQ FS mount: mirrors every object under <objects>/<bucket>/ as a sparse local file of
+the same size and mtime, tagged with the xattrs the extension reads (<namespace>.s3_url and the
+object's ETag as the range server sends it, <namespace>.etag).
+
+A real mount publishes its attributes under "system.cwiqfs", which only a FUSE daemon can
+provide. The fixture uses "user.cwiqfs" on an ordinary filesystem instead, and the benchmark
+points the extension at it with SET cwiqduck_xattr_namespace = 'user.cwiqfs'. The directory
+must live on a filesystem with user xattrs (ext4, xfs, btrfs, tmpfs on Linux 6.6+).
+
+    python3 benchmark/mount_fixture.py --objects /tmp/b/objects --bucket bench --mount /tmp/b/mount
+"""
+
+import argparse
+import os
+
+from range_server import object_etag
+
+DEFAULT_NAMESPACE = "user.cwiqfs"
+
+
+def mirror_object(source, target, s3_url, namespace=DEFAULT_NAMESPACE, resident_ranges=None):
+    """Creates `target` as a stand-in for `source`, redirected to `s3_url`."""
+    os.makedirs(os.path.dirname(target), exist_ok=True)
+    st = os.stat(source)
+    with open(target, "wb") as f:
+        # Sparse: only the size matters, the bytes are served by the range server.
+        f.truncate(st.st_size)
+    if resident_ranges is not None:
+        # Resident ranges are read from this file, so they need the real bytes.
+        with open(source, "rb") as src, open(target, "r+b") as dst:
+            for begin, end in resident_ranges:
+                src.seek(begin)
+                dst.seek(begin)
+                dst.write(src.read(end - begin))
+        value = ",".join("%d-%d" % r for r in resident_ranges) or "none"
+        os.setxattr(target, namespace + ".resident_ranges", value.encode())
+    os.setxattr(target, namespace + ".s3_url", s3_url.encode())
+    os.setxattr(target, namespace + ".etag", object_etag(st).encode())
+    os.utime(target, ns=(st.st_atime_ns, st.st_mtime_ns))
+
+
+def create_mount(objects_root, bucket, mount_root, namespace=DEFAULT_NAMESPACE):
+    """Mirrors every object of `bucket`; returns the number of files created."""
+    bucket_root = os.path.join(objects_root, bucket)
+    count = 0
+    for directory, _, files in os.walk(bucket_root):
+        for name in files:
+            source = os.path.join(directory, name)
+            key = os.path.relpath(source, bucket_root)
+            mirror_object(source, os.path.join(mount_root, key), "s3://%s/%s" % (bucket, key), namespace)
+            count += 1
+    return count
+
+
+def check_xattr_support(directory, namespace=DEFAULT_NAMESPACE):
+    probe = os.path.join(directory, ".xattr-probe")
+    open(probe, "wb").close()
+    try:
+        os.setxattr(probe, namespace + ".probe", b"1")
+    except OSError as e:
+        raise SystemExit(
+            "%s does not support %s.* xattrs (%s); point --workdir at ext4/xfs/btrfs" % (directory, namespace, e)
+        )
+    finally:
+        os.remove(probe)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--objects", required=True, help="range server root")
+    parser.add_argument("--bucket", required=True)
+    parser.add_argument("--mount", required=True, help="directory to create the stand-in files in")
+    parser.add_argument("--namespace", default=DEFAULT_NAMESPACE)
+    args = parser.parse_args()
+
+    os.makedirs(args.mount, exist_ok=True)
+    check_xattr_support(args.mount, args.namespace)
+    count = create_mount(args.objects, args.bucket, args.mount, args.namespace)
+    print("mirrored %d objects into %s (SET cwiqduck_xattr_namespace = '%s')" % (count, args.mount, args.namespace))
+
+
+if __name__ == "__main__":
+    main()
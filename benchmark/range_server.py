@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""Local stand-in for an S3 endpoint: serves files under a root directory path-style
+(/bucket/key -> <root>/bucket/key) with HEAD and single-range GET support, and injects
+latency, bandwidth limits and throttling errors so the redirect read path can be measured
+without a real object store.
+
+Used by run.py in-process; it can also be started on its own:
+
+    python3 benchmark/range_server.py --root /tmp/cwiqduck-bench/objects --latency-ms 20
+"""
+
+import argparse
+import email.utils
+import json
+import math
+import os
+import random
+import re
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+RANGE_PATTERN = re.compile(r"bytes=(\d*)-(\d*)$")
+SEND_CHUNK = 64 * 1024
+# S3 error code and message sent for a status injected through /__fail.
+FAIL_ERRORS = {
+    429: ("TooManyRequests", "Please reduce your request rate."),
+    503: ("SlowDown", "Please reduce your request rate."),
+}
+
+
+class FaultConfig:
+    def __init__(self, latency_ms=0.0, jitter_ms=0.0, bandwidth_mbps=0.0, error_rate=0.0, seed=None):
+        # Time to first byte of every request, uniformly widened by +/- jitter_ms.
+        self.latency_ms = latency_ms
+        self.jitter_ms = jitter_ms
+        # Per-connection throughput cap in megabits per second; 0 = unlimited.
+        self.bandwidth_mbps = bandwidth_mbps
+        # Fraction of GETs answered with 503 SlowDown instead of data.
+        self.error_rate = error_rate
+        # When set, every object GET is answered with this status instead (see /__fail).
+        self.fail_status = 0
+        self.random = random.Random(seed)
+        self.random_lock = threading.Lock()
+
+    def uniform(self):
+        with self.random_lock:
+            return self.random.random()
+
+
+class ServerStats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.head_requests = 0
+            self.get_requests = 0
+            self.range_requests = 0
+            self.errors_injected = 0
+            self.bytes_sent = 0
+            # Service time (first byte to last byte, injected latency included) of every GET.
+            self.get_micros = []
+
+    def snapshot(self):
+        with self.lock:
+            latencies = sorted(self.get_micros)
+            return {
+                "head_requests": self.head_requests,
+                "get_requests": self.get_requests,
+                "range_requests": self.range_requests,
+                "errors_injected": self.errors_injected,
+                "bytes_sent": self.bytes_sent,
+                "get_p50_us": percentile(latencies, 50),
+                "get_p99_us": percentile(latencies, 99),
+            }
+
+
+def object_etag(st):
+    """ETag header of the object with stat result `st`, quotes included, as S3 sends it."""
+    return '"%x-%x"' % (int(st.st_mtime), st.st_size)
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0.0
+    # Nearest rank.
+    index = max(0, math.ceil(pct / 100.0 * len(sorted_values)) - 1)
+    return float(sorted_values[index])
+
+
+class RangeRequestHandler(BaseHTTPRequestHandler):
+    # Keep-alive, like S3: the redirect handle pool relies on warm connections.
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, format, *args):
+        pass
+
+    def resolve(self):
+        path = self.path.split("?", 1)[0]
+        local = os.path.normpath(os.path.join(self.server.root, path.lstrip("/")))
+        if not local.startswith(self.server.root + os.sep) or not os.path.isfile(local):
+            return None
+        return local
+
+    def inject_latency(self):
+        faults = self.server.faults
+        delay = faults.latency_ms + (faults.uniform() * 2 - 1) * faults.jitter_ms
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+
+    def send_object_headers(self, status, local, length, extra=None):
+        st = os.stat(local)
+        self.send_response(status)
+        self.send_header("Content-Length", str(length))
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Accept-Ranges", "bytes")
+        self.send_header("Last-Modified", email.utils.formatdate(st.st_mtime, usegmt=True))
+        self.send_header("ETag", object_etag(st))
+        for name, value in (extra or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+
+    def send_error_body(self, status, code, message):
+        body = (
+            '<?xml version="1.0" encoding="UTF-8"?>\n<Error><Code>%s</Code><Message>%s</Message></Error>' % (code, message)
+        ).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/xml")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if self.command != "HEAD":
+            self.wfile.write(body)
+
+    def control_body(self):
+        """Body of the control endpoint the request is for, or None for object requests. Control
+        endpoints answer HEAD and range GETs like an object, so DuckDB can read them through httpfs
+        (read_json), and are not counted; a query string is ignored, so a distinct one per read
+        keeps DuckDB's caches out of the way. /__reset resets on every request, /__fail/<status>
+        makes every object GET fail with that status until /__fail/0, and /__latency/<ms> sets
+        the injected latency."""
+        path = self.path.split("?", 1)[0]
+        if path == "/__stats":
+            return json.dumps(self.server.stats.snapshot()).encode()
+        if path == "/__reset":
+            self.server.stats.reset()
+            return json.dumps({"reset": True}).encode()
+        if path.startswith("/__fail/") and path[len("/__fail/") :].isdigit():
+            self.server.faults.fail_status = int(path[len("/__fail/") :])
+            return json.dumps({"fail_status": self.server.faults.fail_status}).encode()
+        if path.startswith("/__latency/") and path[len("/__latency/") :].isdigit():
+            self.server.faults.latency_ms = float(path[len("/__latency/") :])
+            return json.dumps({"latency_ms": self.server.faults.latency_ms}).encode()
+        return None
+
+    def parse_range(self, size):
+        """(status, begin, length, extra headers) of a GET of `size` bytes, honouring a Range
+        header; None once a 416 has been sent."""
+        range_header = self.headers.get("Range")
+        if not range_header:
+            return 200, 0, size, {}
+        match = RANGE_PATTERN.match(range_header.strip())
+        if not match or (not match.group(1) and not match.group(2)):
+            self.send_error_body(416, "InvalidRange", "The requested range is not satisfiable.")
+            return None
+        begin, end = 0, size - 1
+        if match.group(1):
+            begin = int(match.group(1))
+            end = min(int(match.group(2)), size - 1) if match.group(2) else size - 1
+        else:
+            # Suffix range: the last N bytes.
+            begin = max(0, size - int(match.group(2)))
+        if begin >= size or begin > end:
+            self.send_error_body(416, "InvalidRange", "The requested range is not satisfiable.")
+            return None
+        return 206, begin, end - begin + 1, {"Content-Range": "bytes %d-%d/%d" % (begin, end, size)}
+
+    def send_control(self, body):
+        if self.command == "HEAD":
+            status, begin, length, extra = 200, 0, len(body), {}
+        else:
+            parsed = self.parse_range(len(body))
+            if parsed is None:
+                return
+            status, begin, length, extra = parsed
+        self.send_response(status)
+        self.send_header("Content-Length", str(length))
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Accept-Ranges", "bytes")
+        self.send_header("Last-Modified", email.utils.formatdate(time.time(), usegmt=True))
+        self.send_header("ETag", '"%x"' % zlib.crc32(body))
+        for name, value in extra.items():
+            self.send_header(name, value)
+        self.end_headers()
+        if self.command != "HEAD":
+            self.wfile.write(body[begin : begin + length])
+
+    def do_HEAD(self):
+        body = self.control_body()
+        if body is not None:
+            self.send_control(body)
+            return
+        local = self.resolve()
+        with self.server.stats.lock:
+            self.server.stats.head_requests += 1
+        self.inject_latency()
+        if local is None:
+            self.send_error_body(404, "NoSuchKey", "The specified key does not exist.")
+            return
+        self.send_object_headers(200, local, os.path.getsize(local))
+
+    def do_GET(self):
+        body = self.control_body()
+        if body is not None:
+            self.send_control(body)
+            return
+        start = time.perf_counter()
+        stats = self.server.stats
+        local = self.resolve()
+        range_header = self.headers.get("Range")
+        with stats.lock:
+            stats.get_requests += 1
+            stats.range_requests += 1 if range_header else 0
+        self.inject_latency()
+        if local is None:
+            self.send_error_body(404, "NoSuchKey", "The specified key does not exist.")
+            return
+        if self.server.faults.error_rate > 0 and self.server.faults.uniform() < self.server.faults.error_rate:
+            with stats.lock:
+                stats.errors_injected += 1
+            self.send_error_body(503, "SlowDown", "Please reduce your request rate.")
+            return
+        fail_status = self.server.faults.fail_status
+        if fail_status:
+            with stats.lock:
+                stats.errors_injected += 1
+            code, message = FAIL_ERRORS.get(fail_status, ("InternalError", "We encountered an internal error."))
+            self.send_error_body(fail_status, code, message)
+            return
+
+        parsed = self.parse_range(os.path.getsize(local))
+        if parsed is None:
+            return
+        status, begin, length, extra = parsed
+        self.send_object_headers(status, local, length, extra)
+        self.send_range(local, begin, length)
+        elapsed_us = (time.perf_counter() - start) * 1e6
+        with stats.lock:
+            stats.bytes_sent += length
+            stats.get_micros.append(elapsed_us)
+
+    def send_range(self, local, begin, length):
+        bandwidth = self.server.faults.bandwidth_mbps * 1e6 / 8
+        started = time.perf_counter()
+        sent = 0
+        with open(local, "rb") as f:
+            f.seek(begin)
+            while sent < length:
+                chunk = f.read(min(SEND_CHUNK, length - sent))
+                if not chunk:
+                    break
+                self.wfile.write(chunk)
+                sent += len(chunk)
+                if bandwidth > 0:
+                    ahead = sent / bandwidth - (time.perf_counter() - started)
+                    if ahead > 0:
+                        time.sleep(ahead)
+
+
+class RangeServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, root, faults, host="127.0.0.1", port=0):
+        super().__init__((host, port), RangeRequestHandler)
+        self.root = os.path.realpath(root)
+        self.faults = faults
+        self.stats = ServerStats()
+
+    @property
+    def endpoint(self):
+        return "%s:%d" % self.server_address[:2]
+
+    def start(self):
+        thread = threading.Thread(target=self.serve_forever, name="range-server", daemon=True)
+        thread.start()
+        return thread
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--root", required=True, help="directory whose subdirectories are buckets")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=0, help="0 picks a free port")
+    parser.add_argument("--latency-ms", type=float, default=0.0)
+    parser.add_argument("--jitter-ms", type=float, default=0.0)
+    parser.add_argument("--bandwidth-mbps", type=float, default=0.0, help="per connection; 0 = unlimited")
+    parser.add_argument("--error-rate", type=float, default=0.0, help="fraction of GETs answered with 503")
+    parser.add_argument("--seed", type=int, default=None)
+    args = parser.parse_args()
+
+    faults = FaultConfig(args.latency_ms, args.jitter_ms, args.bandwidth_mbps, args.error_rate, args.seed)
+    server = RangeServer(args.root, faults, args.host, args.port)
+    print("serving %s on %s" % (server.root, server.endpoint), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,299 @@
+#!/usr/bin/env python3
+"""Benchmarks the redirect read path end to end against a local range server.
+
+Generates a data set with the DuckDB CLI, serves it through range_server.py, mirrors it into a
+fake mount (mount_fixture.py) and runs each workload through the CLI, which resolves the mount
+files to s3:// URLs on the local endpoint. For every workload it reports query latency
+percentiles, throughput, the range GETs the server saw and the extension's own GET percentiles
+from cwiqduck_stats(). It also times CLI start-up with the extension loaded, since short-lived
+processes that never touch the mount should not pay for it.
+
+    make release && python3 benchmark/run.py --latency-ms 20
+    python3 benchmark/run.py --workload parquet_scan --set cwiqduck_block_cache_size=268435456
+
+Results are printed and written as JSON to --output (bench_output.txt by default).
+"""
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from mount_fixture import DEFAULT_NAMESPACE, check_xattr_support, create_mount  # noqa: E402
+from range_server import FaultConfig, RangeServer, percentile  # noqa: E402
+
+BUCKET = "bench"
+PROJECT_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Objects per data set; {rows} scales the two big files.
+DATASET = [
+    "COPY (SELECT i AS id, i % 1000 AS grp, random() AS value, md5(i::VARCHAR) AS payload FROM range({rows}) t(i)) "
+    "TO '{objects}/lineitem.parquet' (FORMAT parquet, ROW_GROUP_SIZE 122880)",
+    "COPY (SELECT i AS id, md5(i::VARCHAR) AS payload, i * 0.5 AS amount FROM range({rows} // 4) t(i)) "
+    "TO '{objects}/events.csv' (FORMAT csv, HEADER)",
+    "COPY (SELECT i % {small_files} AS part, i AS id, random() AS value FROM range({small_files} * 100) t(i)) "
+    "TO '{objects}/small' (FORMAT parquet, PARTITION_BY (part), FILENAME_PATTERN 'file_{{i}}')",
+]
+
+WORKLOADS = {
+    "parquet_scan": {
+        "description": "full scan of one large parquet file (parallel row-group reads)",
+        "sql": "SELECT grp, sum(value), count(*) FROM read_parquet('{mount}/lineitem.parquet') GROUP BY grp",
+    },
+    "parquet_selective": {
+        "description": "footer + a narrow id range: a few small positional reads",
+        "sql": "SELECT sum(value) FROM read_parquet('{mount}/lineitem.parquet') WHERE id BETWEEN 500000 AND 500100",
+    },
+    "csv_sequential": {
+        "description": "sequential read of one CSV file (readahead path)",
+        "sql": "SELECT count(*), sum(amount) FROM read_csv('{mount}/events.csv')",
+    },
+    "small_files_glob": {
+        "description": "glob over many small parquet files (resolution, open and footer cost)",
+        "sql": "SELECT count(*), sum(value) FROM read_parquet('{mount}/small/*/*.parquet')",
+    },
+}
+
+
+def run_cli(duckdb, script):
+    result = subprocess.run([duckdb, "-unsigned", "-batch"], input=script, text=True, capture_output=True)
+    if result.returncode != 0 or "Error:" in result.stderr:
+        raise SystemExit("duckdb failed:\n%s\n%s" % (script, result.stderr))
+    return result
+
+
+def generate_dataset(duckdb, objects, rows, small_files):
+    marker = os.path.join(objects, ".generated-%d-%d" % (rows, small_files))
+    if os.path.exists(marker):
+        return
+    os.makedirs(objects, exist_ok=True)
+    script = ";\n".join(s.format(rows=rows, small_files=small_files, objects=objects) for s in DATASET) + ";\n"
+    print("generating data set (%d rows, %d small files)..." % (rows, small_files), flush=True)
+    run_cli(duckdb, script)
+    open(marker, "w").close()
+
+
+def workload_script(workload, mount, endpoint, iterations, settings, extension, results_dir):
+    """One CLI session: setup, N timed iterations, then the timings and cwiqduck_stats()."""
+    sql = workload["sql"].format(mount=mount)
+    lines = [".output /dev/null"]
+    if extension:
+        lines.append("LOAD '%s';" % extension)
+    lines += [
+        "LOAD httpfs;",
+        "SET s3_endpoint = '%s';" % endpoint,
+        "SET s3_url_style = 'path';",
+        "SET s3_use_ssl = false;",
+        "SET s3_region = 'us-east-1';",
+        "SET s3_access_key_id = 'bench';",
+        "SET s3_secret_access_key = 'bench';",
+        # The fixture's stand-in files carry user.* xattrs; a real mount uses system.cwiqfs.
+        "SET cwiqduck_xattr_namespace = '%s';" % DEFAULT_NAMESPACE,
+    ]
+    lines += ["SET %s = %s;" % (name, value) for name, value in settings]
+    lines += [
+        "CREATE TEMP TABLE bench_marks (iteration INTEGER, phase VARCHAR, at TIMESTAMPTZ);",
+        "SELECT * FROM cwiqduck_stats_reset();",
+    ]
+    for i in range(iterations):
+        # Autocommit: get_current_timestamp() is the start of each INSERT, i.e. just before or
+        # just after the query.
+        lines.append("INSERT INTO bench_marks VALUES (%d, 'start', get_current_timestamp());" % i)
+        lines.append("%s;" % sql)
+        lines.append("INSERT INTO bench_marks VALUES (%d, 'end', get_current_timestamp());" % i)
+    lines += [
+        "COPY (SELECT iteration, epoch_us(max(at) FILTER (phase = 'end')) - "
+        "epoch_us(max(at) FILTER (phase = 'start')) AS micros FROM bench_marks GROUP BY iteration "
+        "ORDER BY iteration) TO '%s/timings.csv' (HEADER);" % results_dir,
+        "COPY (SELECT * FROM cwiqduck_stats()) TO '%s/stats.csv' (HEADER);" % results_dir,
+    ]
+    return "\n".join(lines) + "\n"
+
+
+def measure_startup(duckdb, extension, runs):
+    """Wall time of `runs` CLI processes that load the extension and run one trivial query.
+
+    With --extension the same processes are also timed without the LOAD, so the extension's
+    own share can be separated from CLI start-up. Also checks that loading the extension leaves
+    httpfs unloaded.
+    """
+    def time_script(script):
+        times = []
+        for _ in range(runs):
+            started = time.perf_counter()
+            result = run_cli(duckdb, script)
+            times.append((time.perf_counter() - started) * 1000.0)
+        return sorted(times), result
+
+    load = "LOAD '%s';\n" % extension if extension else ""
+    probe = "SELECT loaded FROM duckdb_extensions() WHERE extension_name = 'httpfs';\n"
+    with_extension, result = time_script(".mode csv\n.headers off\n" + load + probe)
+    report = {
+        "runs": runs,
+        "p50_ms": percentile(with_extension, 50),
+        "p99_ms": percentile(with_extension, 99),
+        "httpfs_loaded_after_load": result.stdout.strip().lower() == "true",
+    }
+    if extension:
+        baseline, _ = time_script("SELECT 1;\n")
+        report["baseline_p50_ms"] = percentile(baseline, 50)
+        report["extension_load_p50_ms"] = report["p50_ms"] - report["baseline_p50_ms"]
+    return report
+
+
+def read_csv(path):
+    with open(path, newline="") as f:
+        return list(csv.DictReader(f))
+
+
+def run_workload(name, workload, args, server, mount):
+    server.stats.reset()
+    with tempfile.TemporaryDirectory(prefix="cwiqduck-bench-") as results_dir:
+        script = workload_script(
+            workload, mount, server.endpoint, args.iterations, args.settings, args.extension, results_dir
+        )
+        started = time.perf_counter()
+        run_cli(args.duckdb, script)
+        session_seconds = time.perf_counter() - started
+        timings = [int(row["micros"]) for row in read_csv(os.path.join(results_dir, "timings.csv"))]
+        stats = {row["name"]: row for row in read_csv(os.path.join(results_dir, "stats.csv"))}
+
+    server_stats = server.stats.snapshot()
+    total_us = sum(timings)
+    warm = sorted(timings[1:]) or sorted(timings)
+    read_bytes = int(stats["positional_read"]["bytes"] or 0) + int(stats["sequential_read"]["bytes"] or 0)
+    return {
+        "workload": name,
+        "iterations": len(timings),
+        "cold_ms": timings[0] / 1000.0 if timings else 0.0,
+        "warm_p50_ms": percentile(warm, 50) / 1000.0,
+        "warm_p99_ms": percentile(warm, 99) / 1000.0,
+        "read_mb_per_s": read_bytes / 1e6 / (total_us / 1e6) if total_us else 0.0,
+        "read_bytes": read_bytes,
+        "gets": int(stats["get"]["value"]),
+        "get_bytes": int(stats["get"]["bytes"] or 0),
+        "get_p50_us": float(stats["get"]["p50_us"] or 0),
+        "get_p99_us": float(stats["get"]["p99_us"] or 0),
+        "server_get_requests": server_stats["get_requests"],
+        "server_head_requests": server_stats["head_requests"],
+        "server_errors_injected": server_stats["errors_injected"],
+        "server_bytes_sent": server_stats["bytes_sent"],
+        "session_seconds": session_seconds,
+        "counters": {key: int(row["value"]) for key, row in stats.items() if not row["bytes"]},
+    }
+
+
+def print_results(results):
+    # (header, result key, width, format)
+    columns = [
+        ("workload", "workload", 18, "s"),
+        ("cold_ms", "cold_ms", 9, ".1f"),
+        ("warm_p50_ms", "warm_p50_ms", 11, ".1f"),
+        ("warm_p99_ms", "warm_p99_ms", 11, ".1f"),
+        ("read_MB/s", "read_mb_per_s", 10, ".1f"),
+        ("GETs", "gets", 7, "d"),
+        ("HEADs", "server_head_requests", 6, "d"),
+        ("get_p50_us", "get_p50_us", 10, ".0f"),
+        ("get_p99_us", "get_p99_us", 10, ".0f"),
+    ]
+    print("  ".join(header.ljust(width) if fmt == "s" else header.rjust(width) for header, _, width, fmt in columns))
+    for result in results:
+        print("  ".join(format(result[key], ("<" if fmt == "s" else ">") + str(width) + fmt)
+                        for _, key, width, fmt in columns))
+
+
+def print_startup(startup):
+    line = "startup: p50 %.1f ms, p99 %.1f ms" % (startup["p50_ms"], startup["p99_ms"])
+    if "extension_load_p50_ms" in startup:
+        line += ", extension load p50 %.1f ms" % startup["extension_load_p50_ms"]
+    line += ", httpfs loaded by LOAD: %s" % ("yes" if startup["httpfs_loaded_after_load"] else "no")
+    print(line + "\n")
+
+
+def parse_setting(value):
+    name, sep, setting = value.partition("=")
+    if not sep:
+        raise argparse.ArgumentTypeError("expected name=value, got %r" % value)
+    return name.strip(), setting.strip()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--duckdb", default=os.path.join(PROJECT_ROOT, "build", "release", "duckdb"),
+                        help="DuckDB CLI with cwiqduck linked in (default: the release build)")
+    parser.add_argument("--extension", help="path of a loadable cwiqduck build, for a CLI without it linked in")
+    parser.add_argument("--workdir", default=os.path.join(tempfile.gettempdir(), "cwiqduck-bench"),
+                        help="data set and fake mount location; must support user xattrs")
+    parser.add_argument("--workload", action="append", choices=sorted(WORKLOADS), help="default: all")
+    parser.add_argument("--iterations", type=int, default=5)
+    parser.add_argument("--rows", type=int, default=2000000)
+    parser.add_argument("--small-files", type=int, default=500)
+    parser.add_argument("--latency-ms", type=float, default=10.0)
+    parser.add_argument("--jitter-ms", type=float, default=2.0)
+    parser.add_argument("--bandwidth-mbps", type=float, default=0.0, help="per connection; 0 = unlimited")
+    parser.add_argument("--error-rate", type=float, default=0.0)
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--set", dest="settings", action="append", type=parse_setting, default=[],
+                        metavar="NAME=VALUE", help="extra DuckDB setting for every workload, e.g. "
+                        "cwiqduck_block_cache_size=268435456")
+    parser.add_argument("--startup-runs", type=int, default=20, help="CLI start-ups to time; 0 skips it")
+    parser.add_argument("--output", default=os.path.join(PROJECT_ROOT, "bench_output.txt"))
+    args = parser.parse_args()
+
+    if not os.path.exists(args.duckdb):
+        raise SystemExit("%s not found; run `make release` or pass --duckdb" % args.duckdb)
+    startup = None
+    if args.startup_runs > 0:
+        print("timing %d CLI start-ups..." % args.startup_runs, flush=True)
+        startup = measure_startup(args.duckdb, args.extension, args.startup_runs)
+
+    objects = os.path.join(args.workdir, "objects")
+    mount = os.path.join(args.workdir, "mount")
+    generate_dataset(args.duckdb, os.path.join(objects, BUCKET), args.rows, args.small_files)
+    os.makedirs(mount, exist_ok=True)
+    check_xattr_support(mount)
+    create_mount(objects, BUCKET, mount)
+
+    faults = FaultConfig(args.latency_ms, args.jitter_ms, args.bandwidth_mbps, args.error_rate, args.seed)
+    server = RangeServer(objects, faults)
+    server.start()
+
+    results = []
+    try:
+        for name in args.workload or list(WORKLOADS):
+            print("running %s: %s" % (name, WORKLOADS[name]["description"]), flush=True)
+            results.append(run_workload(name, WORKLOADS[name], args, server, mount))
+    finally:
+        server.shutdown()
+
+    print()
+    if startup:
+        print_startup(startup)
+    print_results(results)
+    report = {
+        "config": {
+            "latency_ms": args.latency_ms,
+            "jitter_ms": args.jitter_ms,
+            "bandwidth_mbps": args.bandwidth_mbps,
+            "error_rate": args.error_rate,
+            "rows": args.rows,
+            "small_files": args.small_files,
+            "iterations": args.iterations,
+            "settings": dict(args.settings),
+        },
+        "startup": startup,
+        "results": results,
+    }
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+    print("\nwrote %s" % args.output)
+
+
+if __name__ == "__main__":
+    main()
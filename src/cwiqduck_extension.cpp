@@ -1,6 +1,7 @@
 #define DUCKDB_EXTENSION_MAIN
 
 #include "cwiqduck_extension.hpp"
+#include "s3redirect_settings.hpp"
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/file_opener.hpp"
@@ -13,16 +14,20 @@
 #include "duckdb/common/local_file_system.hpp"
 #include "duckdb/common/string_util.hpp"
 #include "duckdb/function/scalar_function.hpp"
+#include "duckdb/function/table_function.hpp"
 #include "duckdb/logging/log_manager.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/extension_helper.hpp"
+#include "duckdb/storage/buffer/buffer_pool.hpp"
 #include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
 
-#ifdef __linux__
-#include <sys/xattr.h>
-#include <sys/stat.h>
-#endif
-
+#include <chrono>
+#include <cmath>
 #include <errno.h>
 #include <cstring>
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 namespace duckdb {
 
@@ -36,86 +41,725 @@ unique_ptr<FileHandle> S3RedirectFileHandle::OpenHandle() const {
 	// (no two threads share a handle's mutable state), not from any httpfs-internal flag.
 	auto flags = FileFlags::FILE_FLAGS_READ;
 	auto &main_fs = FileSystem::GetFileSystem(db_instance);
+	OpenFileInfo file(s3_url);
+	if (seed_http_metadata) {
+		// httpfs only skips its HEAD when size, last_modified and etag are all present, and it
+		// compares the etag with the ETag header of every range GET, so it must be the object's
+		// real one; a changed object then fails the read instead of mixing versions.
+		file.extended_info = make_shared_ptr<ExtendedOpenFileInfo>();
+		auto &options = file.extended_info->options;
+		options["file_size"] = Value::UBIGINT(known_content_length);
+		options["last_modified"] = Value::TIMESTAMP(last_modified_time);
+		options["etag"] = Value(etag);
+	}
+	try {
 #ifdef DUCKDB_HAS_OPENER_FILESYSTEM
-	// v1.5.3+: DatabaseFileSystem (OpenerFileSystem) auto-injects the db-level opener
-	// and explicitly rejects a caller-supplied one.
-	return main_fs.OpenFile(s3_url, flags, nullptr);
+		// v1.5.3+: DatabaseFileSystem (OpenerFileSystem) auto-injects the db-level opener
+		// and explicitly rejects a caller-supplied one.
+		return main_fs.OpenFile(file, flags, nullptr);
 #else
-	// v1.4.x: no auto-injection; pass the opener so httpfs can read S3 credentials.
-	return main_fs.OpenFile(s3_url, flags, file_opener);
+		// v1.4.x: no auto-injection; pass the opener so httpfs can read S3 credentials.
+		return main_fs.OpenFile(file, flags, file_opener);
 #endif
+	} catch (const std::exception &e) {
+		// The first handle is opened by the first read, not by OpenFile; report a bad URL or
+		// missing credentials the way a failed open does.
+		throw IOException("Failed to redirect to S3: " + string(e.what()));
+	}
 }
 
 S3RedirectFileHandle::BorrowedHandle S3RedirectFileHandle::BorrowHandle() {
-	{
-		std::lock_guard<std::mutex> lk(pool_mu);
-		if (!idle_pool.empty()) {
-			auto h = std::move(idle_pool.back());
-			idle_pool.pop_back();
-			return BorrowedHandle(*this, std::move(h));
-		}
+	auto h = handle_pool.Acquire(object_key);
+	if (h) {
+		return BorrowedHandle(*this, std::move(h));
 	}
-	// Pool empty: open a new handle without holding the lock (avoids blocking
-	// other threads returning handles while a HEAD/GET is in flight).
+	// Pool empty: open a new handle. The pool lock is not held here, so other threads
+	// keep borrowing and returning while this open is in flight.
 	CWIQ_LOG_DEBUG(db_instance, "BorrowHandle: pool miss, opening new handle for %s", s3_url);
 	return BorrowedHandle(*this, OpenHandle());
 }
 
 void S3RedirectFileHandle::ReturnHandle(unique_ptr<FileHandle> h) {
-	std::lock_guard<std::mutex> lk(pool_mu);
-	idle_pool.push_back(std::move(h));
-	CWIQ_LOG_DEBUG(db_instance, "ReturnHandle: pool size now %s for %s", std::to_string(idle_pool.size()), s3_url);
+	handle_pool.Release(object_key, std::move(h));
+}
+
+static idx_t ElapsedMicros(std::chrono::steady_clock::time_point start) {
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	return idx_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+// Reads are queued per client for fair sharing; handles opened without a client context (e.g.
+// from a background thread) share one queue.
+static uintptr_t ClientKey(optional_ptr<FileOpener> opener) {
+	auto context = FileOpener::TryGetClientContext(opener);
+	return context ? reinterpret_cast<uintptr_t>(context.get()) : 0;
+}
+
+#ifdef DUCKDB_HAS_OPENER_FILESYSTEM
+// Pool handles are opened with the database-level opener (see OpenHandle), so every client reads
+// with the same credentials and may reuse their handles and the bytes they fetched.
+static string ScopeToClient(const string &object_key, optional_ptr<FileOpener> opener) {
+	return object_key;
 }
+#else
+// Identifies a client; unlike the context's address, the id of a closed connection is never handed
+// to a new one, and the pid keeps the disk cache (shared between processes) apart too.
+struct S3RedirectPoolClient : public ClientContextState {
+	static constexpr const char *STATE_KEY = "cwiqduck_pool_client";
+
+	S3RedirectPoolClient() : id(next_id.fetch_add(1, std::memory_order_relaxed)) {
+	}
+
+	static std::atomic<idx_t> next_id;
+	const idx_t id;
+};
+
+std::atomic<idx_t> S3RedirectPoolClient::next_id {1};
+
+// Pool handles are opened with the opener of the client that opened the file, which httpfs
+// reads settings and credentials through. Handles and everything fetched with them (block cache,
+// single-flight, disk cache) are therefore keyed by client: bytes one client's credentials fetched
+// are never served to another client, which may not be allowed to read the object. Entries left
+// behind by a closed connection are never used again and age out; on these versions the disk
+// cache is thus not reused by later connections or processes.
+static string ScopeToClient(const string &object_key, optional_ptr<FileOpener> opener) {
+	auto context = FileOpener::TryGetClientContext(opener);
+	if (!context) {
+		return object_key;
+	}
+	auto client = context->registered_state->GetOrCreate<S3RedirectPoolClient>(S3RedirectPoolClient::STATE_KEY);
+#ifdef __linux__
+	auto pid = std::to_string(getpid());
+#else
+	string pid = "0";
+#endif
+	return object_key + "#" + pid + "." + std::to_string(client->id);
+}
+#endif
 
 // ---------------------------------------------------------------------------
 // S3RedirectFileHandle — public interface
 // ---------------------------------------------------------------------------
 
-S3RedirectFileHandle::S3RedirectFileHandle(FileSystem &fs, DatabaseInstance &db, const string &url,
-                                           idx_t content_length, timestamp_t last_modified,
-                                           optional_ptr<FileOpener> opener)
-    : FileHandle(fs, url, FileFlags::FILE_FLAGS_READ), s3_url(url), known_content_length(content_length),
-      last_modified_time(last_modified), db_instance(db), file_opener(opener) {
-	// Open the primary handle eagerly (sequential cursor / metadata ops).
-	// This also validates the S3 URL and credentials at open time rather than
-	// deferring errors to the first read.
-	primary_handle = OpenHandle();
+S3RedirectFileHandle::S3RedirectFileHandle(S3RedirectProtocolFileSystem &fs, DatabaseInstance &db, const string &url,
+                                           idx_t content_length, timestamp_t last_modified, string etag_p,
+                                           string object_key_p, optional_ptr<FileOpener> opener,
+                                           const S3RedirectSettings &settings,
+                                           const string &local_path, shared_ptr<const S3RedirectResidency> residency_p)
+    : S3RedirectHandle(fs, url, FileFlags::FILE_FLAGS_READ), s3_url(url), known_content_length(content_length),
+      last_modified_time(last_modified), db_instance(db), file_opener(opener), etag(std::move(etag_p)),
+      seed_http_metadata(settings.seed_http_metadata && !etag.empty()), handle_pool(fs.GetHandlePool()),
+      block_cache(fs.GetBlockCache()), block_size(MaxValue<idx_t>(settings.block_cache_block_size, 1)),
+      object_key(ScopeToClient(object_key_p, opener)), disk_cache(fs.GetDiskCache()),
+      disk_cache_object_hash(S3RedirectDiskCache::ObjectHash(object_key)),
+      task_pool(fs.GetTaskPool()), readahead_initial_window(settings.readahead_initial_window),
+      readahead_max_window(settings.readahead_max_window),
+      parallel_read_threshold(settings.parallel_read_threshold),
+      parallel_read_part_size(MaxValue<idx_t>(settings.parallel_read_part_size, 1)),
+      parallel_read_max_parts(settings.parallel_read_max_parts), single_flight(fs.GetSingleFlight()),
+      single_flight_enabled(settings.single_flight), hedging(fs.GetHedging()),
+      endpoint_latency(hedging.GetEndpoint(url)), io_scheduler(fs.GetIOScheduler()),
+      io_endpoint(io_scheduler.GetEndpoint(url)), io_client(ClientKey(opener)), stats(fs.GetStats()),
+      residency(std::move(residency_p)) {
+	auto client_profile = S3RedirectQueryProfile::Get(opener);
+	if (client_profile) {
+		query_profile = client_profile->GetFile(local_path);
+	}
+	// Size and mtime are already known from CWIQ FS, so nothing is opened here and the open path
+	// costs no network round trip. Bad URLs or credentials surface on the first read instead. The
+	// first underlying handle sends a HEAD unless it is seeded (which needs an ETag), but handles
+	// come back from the pool warm, so reopening an object does not repeat it.
+	if (settings.coalesce_window_us > 0) {
+		// Merged GETs stay below the split threshold so a coalesced read is never re-split.
+		auto max_span = MaxValue<idx_t>(parallel_read_threshold, 2) - 1;
+		coalescer = make_uniq<S3RedirectReadCoalescer>(
+		    [this](data_ptr_t buffer, idx_t nr_bytes, idx_t location) { FetchDirect(buffer, nr_bytes, location); },
+		    std::chrono::microseconds(settings.coalesce_window_us), settings.coalesce_max_gap, max_span);
+	}
+	if (residency && !residency->Empty()) {
+		try {
+			local_handle = fs.GetLocalFileSystem().OpenFile(local_path, FileFlags::FILE_FLAGS_READ);
+		} catch (const std::exception &e) {
+			// Not fatal: every byte is still available from S3.
+			CWIQ_LOG_DEBUG(db_instance, "Open: local-first reads disabled for %s: %s", local_path, e.what());
+		}
+	}
+	if (settings.small_object_threshold > 0 && known_content_length > 0 &&
+	    known_content_length <= settings.small_object_threshold && !local_handle) {
+		// Through the block cache, so reopening the object does not download it again.
+		whole_object = make_uniq<S3RedirectPrefetcher>(
+		    task_pool,
+		    [this](data_ptr_t target, idx_t length, idx_t offset) { ReadRedirected(target, length, offset); },
+		    known_content_length);
+		CWIQ_LOG_DEBUG(db_instance, "Open: fetching all %s bytes of %s", std::to_string(known_content_length),
+		               s3_url);
+		whole_object->Prefetch(0, known_content_length);
+		return;
+	}
+	if (settings.prefetch_budget > 0) {
+		prefetcher = make_uniq<S3RedirectPrefetcher>(
+		    task_pool,
+		    [this](data_ptr_t target, idx_t length, idx_t offset) {
+			    if (local_handle) {
+				    ReadLocalFirst(target, length, offset, false);
+			    } else {
+				    ReadRemote(target, length, offset);
+				    PublishPrefetchedBlocks(target, length, offset);
+			    }
+		    },
+		    settings.prefetch_budget);
+		if (settings.parquet_footer_prefetch > 0 && !local_handle && known_content_length > 0 &&
+		    StringUtil::EndsWith(StringUtil::Lower(local_path), ".parquet")) {
+			PrefetchParquetFooter(settings.parquet_footer_prefetch);
+		}
+	}
+}
+
+void S3RedirectFileHandle::PrefetchParquetFooter(idx_t footer_prefetch) {
+	// The reader's first requests are the 8-byte tail and then the footer; one speculative GET of
+	// the tail, started now, covers both for typical footers while DuckDB is still opening.
+	// Skipped when an earlier open already left the last block in the block cache.
+	if (block_cache.Enabled() && block_cache.Get(object_key, block_size, (known_content_length - 1) / block_size)) {
+		return;
+	}
+	auto start = known_content_length - MinValue<idx_t>(footer_prefetch, known_content_length);
+	if (block_cache.Enabled()) {
+		// Whole blocks, so the footer lands in the block cache for later opens of this object.
+		start = start / block_size * block_size;
+	}
+	auto length = known_content_length - start;
+	CWIQ_LOG_DEBUG(db_instance, "Open: prefetching the last %s bytes of %s", std::to_string(length), s3_url);
+	prefetcher->Prefetch(known_content_length - length, length);
+}
+
+void S3RedirectFileHandle::PublishPrefetchedBlocks(const_data_ptr_t data, idx_t nr_bytes, idx_t location) {
+	if (!block_cache.Enabled()) {
+		return;
+	}
+	auto read_end = location + nr_bytes;
+	for (auto block_index = (location + block_size - 1) / block_size;; block_index++) {
+		auto block_start = block_index * block_size;
+		auto block_end = MinValue<idx_t>(block_start + block_size, known_content_length);
+		if (block_start >= known_content_length || block_end > read_end) {
+			break;
+		}
+		auto size = block_end - block_start;
+		auto block_data = make_unsafe_uniq_array_uninitialized<data_t>(size);
+		memcpy(block_data.get(), data + (block_start - location), size);
+		block_cache.Put(object_key, block_size, block_index,
+		                make_shared_ptr<S3RedirectBlock>(std::move(block_data), size));
+	}
+}
+
+void S3RedirectFileHandle::Prefetch(idx_t location, idx_t nr_bytes) {
+	if (!prefetcher || location >= known_content_length) {
+		return;
+	}
+	prefetcher->Prefetch(location, MinValue<idx_t>(nr_bytes, known_content_length - location));
+}
+
+S3RedirectFileHandle::~S3RedirectFileHandle() {
+	// Readahead and prefetch tasks call back into this handle; wait for them before any member
+	// goes away.
+	readahead.reset();
+	prefetcher.reset();
+	whole_object.reset();
+	if (coalescer) {
+		stats.AddCoalescedReads(coalescer->GetMergedReads());
+	}
+	// So do the losing attempts of hedged reads.
+	std::unique_lock<std::mutex> lk(hedge_lock);
+	hedge_attempts_done.wait(lk, [this]() { return hedge_attempts_in_flight == 0; });
 }
 
 FileHandle &S3RedirectFileHandle::GetPrimaryHandle() {
-	D_ASSERT(primary_handle);
+	if (!primary_handle) {
+		primary_handle = OpenHandle();
+	}
 	return *primary_handle;
 }
 
+void S3RedirectFileHandle::Seek(idx_t location) {
+	if (readahead_max_window == 0 && !whole_object) {
+		GetPrimaryHandle().Seek(location);
+		return;
+	}
+	if (readahead && location != sequential_position) {
+		readahead->Reset();
+	}
+	sequential_position = location;
+}
+
+idx_t S3RedirectFileHandle::SeekPosition() {
+	if (readahead_max_window > 0 || whole_object) {
+		return sequential_position;
+	}
+	// An unopened cursor has not moved yet.
+	return primary_handle ? primary_handle->SeekPosition() : 0;
+}
+
 idx_t S3RedirectFileHandle::GetFileSize() {
 	return known_content_length;
 }
 
 void S3RedirectFileHandle::Close() {
-	if (primary_handle) {
-		primary_handle->Close();
+	readahead.reset();
+	prefetcher.reset();
+	whole_object.reset();
+	if (local_handle) {
+		local_handle->Close();
+		local_handle.reset();
 	}
-	std::lock_guard<std::mutex> lk(pool_mu);
-	for (auto &h : idle_pool) {
-		if (h) {
-			h->Close();
-		}
+	// The primary cursor is as good as any pooled handle for positional reads, so it is handed
+	// to the shared pool rather than closed; the next open of this object (by the same client,
+	// where object keys are scoped to one) starts warm.
+	if (primary_handle) {
+		handle_pool.Release(object_key, std::move(primary_handle));
 	}
-	idle_pool.clear();
 }
 
-// Positional read: borrow an exclusive handle from the pool so no two threads
-// share any mutable handle state regardless of how the underlying httpfs is implemented.
+// Positional read: small reads go through the block cache; everything else (and every cache
+// miss) borrows an exclusive handle from the pool so no two threads share any mutable handle
+// state regardless of how the underlying httpfs is implemented.
 void S3RedirectFileHandle::Read(void *buffer, idx_t nr_bytes, idx_t location) {
 	CWIQ_LOG_TRACE(db_instance, "Read: %s bytes @ offset %s", std::to_string(nr_bytes), std::to_string(location));
-	auto borrowed = BorrowHandle();
-	borrowed.get().Read(buffer, nr_bytes, location);
+	if (nr_bytes == 0) {
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	if (whole_object && whole_object->TryRead(static_cast<data_ptr_t>(buffer), nr_bytes, location)) {
+		if (query_profile) {
+			query_profile->cache_hits.fetch_add(1, std::memory_order_relaxed);
+		}
+	} else if (prefetcher && prefetcher->TryRead(static_cast<data_ptr_t>(buffer), nr_bytes, location)) {
+		// Served from a prefetch.
+		if (query_profile) {
+			query_profile->cache_hits.fetch_add(1, std::memory_order_relaxed);
+		}
+	} else if (local_handle && location + nr_bytes <= known_content_length) {
+		ReadLocalFirst(buffer, nr_bytes, location, true);
+	} else {
+		ReadRedirected(buffer, nr_bytes, location);
+	}
+	stats.Record(S3RedirectStats::Operation::POSITIONAL_READ, ElapsedMicros(start), nr_bytes);
+	if (query_profile) {
+		query_profile->reads.fetch_add(1, std::memory_order_relaxed);
+		query_profile->bytes_read.fetch_add(nr_bytes, std::memory_order_relaxed);
+	}
+}
+
+void S3RedirectFileHandle::ReadRedirected(void *buffer, idx_t nr_bytes, idx_t location) {
+	// Reads past EOF go straight to httpfs so its error reporting is unchanged; multi-block
+	// reads (whole row groups) bypass the cache so they cannot flush the hot footer/dictionary set.
+	bool cacheable = block_cache.Enabled() && location + nr_bytes <= known_content_length &&
+	                 nr_bytes <= block_size * MAX_CACHED_BLOCKS_PER_READ;
+	if (cacheable) {
+		ReadThroughBlockCache(buffer, nr_bytes, location);
+	} else {
+		ReadRemote(buffer, nr_bytes, location);
+	}
+}
+
+void S3RedirectFileHandle::ReadLocalFirst(void *buffer, idx_t nr_bytes, idx_t location, bool use_block_cache) {
+	auto out = static_cast<data_ptr_t>(buffer);
+	auto read_end = location + nr_bytes;
+	auto redirect = [&](idx_t start, idx_t end) {
+		if (use_block_cache) {
+			ReadRedirected(out + (start - location), end - start, start);
+		} else {
+			ReadRemote(out + (start - location), end - start, start);
+		}
+	};
+	auto current = location;
+	for (auto &range : residency->ranges) {
+		if (range.second <= current) {
+			continue;
+		}
+		if (range.first >= read_end) {
+			break;
+		}
+		if (range.first > current) {
+			redirect(current, range.first);
+			current = range.first;
+		}
+		auto local_end = MinValue<idx_t>(range.second, read_end);
+		auto start = std::chrono::steady_clock::now();
+		// pread on the mount: safe to share one local handle between threads.
+		local_handle->Read(out + (current - location), local_end - current, current);
+		stats.Record(S3RedirectStats::Operation::LOCAL_READ, ElapsedMicros(start), local_end - current);
+		if (query_profile) {
+			query_profile->local_bytes.fetch_add(local_end - current, std::memory_order_relaxed);
+		}
+		current = local_end;
+	}
+	if (current < read_end) {
+		redirect(current, read_end);
+	}
+}
+
+void S3RedirectFileHandle::ReadRemote(void *buffer, idx_t nr_bytes, idx_t location) {
+	if (disk_cache.Enabled() && location + nr_bytes <= known_content_length) {
+		ReadThroughDiskCache(buffer, nr_bytes, location);
+	} else {
+		FetchRange(buffer, nr_bytes, location);
+	}
+}
+
+void S3RedirectFileHandle::FetchRange(void *buffer, idx_t nr_bytes, idx_t location) {
+	if (!single_flight_enabled) {
+		FetchUnshared(buffer, nr_bytes, location);
+		return;
+	}
+	single_flight.Read(object_key, location, nr_bytes, static_cast<data_ptr_t>(buffer),
+	                   [&](data_ptr_t out) { FetchUnshared(out, nr_bytes, location); });
+}
+
+void S3RedirectFileHandle::FetchUnshared(void *buffer, idx_t nr_bytes, idx_t location) {
+	if (parallel_read_max_parts > 1 && nr_bytes >= parallel_read_threshold) {
+		FetchParallel(buffer, nr_bytes, location);
+	} else if (coalescer && location + nr_bytes <= known_content_length) {
+		// In-bounds only: a merged span must never reach past EOF on behalf of another read.
+		coalescer->Read(static_cast<data_ptr_t>(buffer), nr_bytes, location);
+	} else {
+		FetchDirect(buffer, nr_bytes, location);
+	}
+}
+
+void S3RedirectFileHandle::FetchParallel(void *buffer, idx_t nr_bytes, idx_t location) {
+	// Part boundaries sit on multiples of the part size so repeated reads of the same row group
+	// produce identical GETs (friendlier to any cache in front of the object store).
+	auto read_end = location + nr_bytes;
+	vector<idx_t> part_starts;
+	for (auto offset = location; offset < read_end;
+	     offset = (offset / parallel_read_part_size + 1) * parallel_read_part_size) {
+		part_starts.push_back(offset);
+	}
+	auto out = static_cast<data_ptr_t>(buffer);
+	CWIQ_LOG_TRACE(db_instance, "FetchParallel: %s bytes @ offset %s in %s parts", std::to_string(nr_bytes),
+	               std::to_string(location), std::to_string(part_starts.size()));
+	task_pool.ParallelFor(part_starts.size(), parallel_read_max_parts, [&](idx_t part) {
+		auto part_start = part_starts[part];
+		auto part_end = part + 1 < part_starts.size() ? part_starts[part + 1] : read_end;
+		FetchDirect(out + (part_start - location), part_end - part_start, part_start);
+	});
+}
+
+idx_t S3RedirectFileHandle::ReadPooled(void *buffer, idx_t nr_bytes, idx_t location) {
+	// The slot is held only for the GET itself, never while waiting on other reads.
+	auto queued = std::chrono::steady_clock::now();
+	auto slot = io_scheduler.Acquire(io_endpoint, io_client);
+	auto start = std::chrono::steady_clock::now();
+	try {
+		auto borrowed = BorrowHandle();
+		borrowed.get().Read(buffer, nr_bytes, location);
+	} catch (const std::exception &e) {
+		if (S3RedirectIOScheduler::IsThrottlingError(e.what())) {
+			CWIQ_LOG_DEBUG(db_instance, "ReadPooled: throttled reading %s: %s", s3_url, e.what());
+			slot.SetThrottled();
+		}
+		throw;
+	}
+	auto elapsed = ElapsedMicros(start);
+	stats.Record(S3RedirectStats::Operation::GET, elapsed, nr_bytes);
+	if (query_profile) {
+		auto queue_wait = std::chrono::duration_cast<std::chrono::microseconds>(start - queued);
+		query_profile->requests.fetch_add(1, std::memory_order_relaxed);
+		query_profile->request_bytes.fetch_add(nr_bytes, std::memory_order_relaxed);
+		query_profile->request_micros.fetch_add(elapsed, std::memory_order_relaxed);
+		query_profile->queue_wait_micros.fetch_add(idx_t(queue_wait.count()), std::memory_order_relaxed);
+	}
+	return elapsed;
+}
+
+void S3RedirectFileHandle::FetchDirect(void *buffer, idx_t nr_bytes, idx_t location) {
+	if (!hedging.Enabled()) {
+		ReadPooled(buffer, nr_bytes, location);
+		return;
+	}
+	endpoint_latency.CountRequest();
+	auto deadline_us = hedging.GetDeadline(endpoint_latency);
+	if (deadline_us > 0) {
+		FetchHedged(buffer, nr_bytes, location, deadline_us);
+		return;
+	}
+	// Not enough samples for a deadline yet: read directly and learn the endpoint's latency.
+	endpoint_latency.Record(ReadPooled(buffer, nr_bytes, location));
+}
+
+// Two attempts at the same range, each into a private buffer because the loser may still be
+// writing after the caller has returned. Attempt 0 starts immediately, attempt 1 only once the
+// deadline has passed and the hedge budget allows it.
+struct S3RedirectFileHandle::HedgedRead {
+	enum class AttemptState : uint8_t { NOT_SCHEDULED, PENDING, RUNNING, DONE };
+	struct Attempt {
+		AttemptState state = AttemptState::NOT_SCHEDULED;
+		unsafe_unique_array<data_t> data;
+		std::exception_ptr error;
+	};
+
+	HedgedRead(idx_t nr_bytes_p, idx_t location_p) : nr_bytes(nr_bytes_p), location(location_p) {
+	}
+
+	const idx_t nr_bytes;
+	const idx_t location;
+	std::mutex lock;
+	std::condition_variable changed;
+	Attempt attempts[2];
+	idx_t winner = DConstants::INVALID_INDEX;
+};
+
+void S3RedirectFileHandle::RunHedgeAttempt(HedgedRead &read, idx_t attempt) {
+	{
+		std::lock_guard<std::mutex> lk(read.lock);
+		if (read.attempts[attempt].state != HedgedRead::AttemptState::PENDING) {
+			return;
+		}
+		read.attempts[attempt].state = HedgedRead::AttemptState::RUNNING;
+	}
+	unsafe_unique_array<data_t> data;
+	std::exception_ptr error;
+	try {
+		data = make_unsafe_uniq_array_uninitialized<data_t>(read.nr_bytes);
+		endpoint_latency.Record(ReadPooled(data.get(), read.nr_bytes, read.location));
+	} catch (...) {
+		error = std::current_exception();
+	}
+	{
+		std::lock_guard<std::mutex> lk(read.lock);
+		auto &state = read.attempts[attempt];
+		state.data = std::move(data);
+		state.error = error;
+		state.state = HedgedRead::AttemptState::DONE;
+		if (!error && read.winner == DConstants::INVALID_INDEX) {
+			read.winner = attempt;
+		}
+	}
+	read.changed.notify_all();
+}
+
+void S3RedirectFileHandle::ScheduleHedgeAttempt(shared_ptr<HedgedRead> read, idx_t attempt) {
+	{
+		std::lock_guard<std::mutex> lk(read->lock);
+		read->attempts[attempt].state = HedgedRead::AttemptState::PENDING;
+	}
+	{
+		std::lock_guard<std::mutex> lk(hedge_lock);
+		hedge_attempts_in_flight++;
+	}
+	task_pool.Schedule([this, read, attempt]() {
+		RunHedgeAttempt(*read, attempt);
+		// Notify under the lock: the destructor may free this handle as soon as it sees zero.
+		std::lock_guard<std::mutex> lk(hedge_lock);
+		hedge_attempts_in_flight--;
+		hedge_attempts_done.notify_all();
+	});
+}
+
+void S3RedirectFileHandle::FetchHedged(void *buffer, idx_t nr_bytes, idx_t location, idx_t deadline_us) {
+	using AttemptState = HedgedRead::AttemptState;
+	auto read = make_shared_ptr<HedgedRead>(nr_bytes, location);
+	ScheduleHedgeAttempt(read, 0);
+
+	std::unique_lock<std::mutex> lk(read->lock);
+	auto &primary = read->attempts[0];
+	auto &hedge = read->attempts[1];
+	auto primary_done = [&primary]() {
+		return primary.state == AttemptState::DONE;
+	};
+	if (!read->changed.wait_for(lk, std::chrono::microseconds(deadline_us), primary_done) &&
+	    primary.state == AttemptState::RUNNING) {
+		// A straggler: duplicate it if the endpoint's hedge budget allows.
+		lk.unlock();
+		if (hedging.TryStartHedge(endpoint_latency)) {
+			CWIQ_LOG_DEBUG(db_instance, "FetchHedged: hedging %s bytes @ offset %s of %s after %sus",
+			               std::to_string(nr_bytes), std::to_string(location), s3_url, std::to_string(deadline_us));
+			ScheduleHedgeAttempt(read, 1);
+		}
+		lk.lock();
+	}
+	while (read->winner == DConstants::INVALID_INDEX) {
+		bool running = false;
+		bool pending = false;
+		for (auto &attempt : read->attempts) {
+			running |= attempt.state == AttemptState::RUNNING;
+			pending |= attempt.state == AttemptState::PENDING;
+		}
+		if (!running && !pending) {
+			// Every attempt failed.
+			break;
+		}
+		if (!running) {
+			// No pool thread has picked an attempt up; run it here rather than wait behind others.
+			lk.unlock();
+			RunHedgeAttempt(*read, primary.state == AttemptState::PENDING ? 0 : 1);
+			lk.lock();
+			continue;
+		}
+		read->changed.wait(lk);
+	}
+	if (read->winner == DConstants::INVALID_INDEX) {
+		std::rethrow_exception(primary.error ? primary.error : hedge.error);
+	}
+	if (read->winner == 1) {
+		hedging.RecordHedgeWin();
+	}
+	// A hedge still queued behind other pool work is no longer needed.
+	if (hedge.state == AttemptState::PENDING) {
+		hedge.state = AttemptState::DONE;
+	}
+	// The winning attempt is DONE and never written again; the copy needs no lock.
+	auto &winner = read->attempts[read->winner];
+	lk.unlock();
+	memcpy(buffer, winner.data.get(), nr_bytes);
+}
+
+void S3RedirectFileHandle::ReadThroughDiskCache(void *buffer, idx_t nr_bytes, idx_t location) {
+	const auto chunk_size = S3RedirectDiskCache::CHUNK_SIZE;
+	auto out = static_cast<data_ptr_t>(buffer);
+	auto read_end = location + nr_bytes;
+	// Copies the overlap of chunk data starting at `data_offset` into the caller's buffer.
+	auto copy_overlap = [&](const_data_ptr_t data, idx_t data_offset, idx_t data_length) {
+		auto copy_begin = MaxValue<idx_t>(location, data_offset);
+		auto copy_end = MinValue<idx_t>(read_end, data_offset + data_length);
+		memcpy(out + (copy_begin - location), data + (copy_begin - data_offset), copy_end - copy_begin);
+	};
+
+	auto first_chunk = location / chunk_size;
+	auto last_chunk = (read_end - 1) / chunk_size;
+	auto chunk_data = make_unsafe_uniq_array_uninitialized<data_t>(chunk_size);
+	idx_t run_begin = last_chunk + 1;
+	for (auto chunk = first_chunk; chunk <= last_chunk + 1; chunk++) {
+		auto chunk_offset = chunk * chunk_size;
+		if (chunk <= last_chunk) {
+			auto length = MinValue<idx_t>(chunk_size, known_content_length - chunk_offset);
+			if (!disk_cache.ReadChunk(disk_cache_object_hash, chunk, chunk_data.get(), length)) {
+				if (query_profile) {
+					query_profile->cache_misses.fetch_add(1, std::memory_order_relaxed);
+				}
+				run_begin = MinValue<idx_t>(run_begin, chunk);
+				continue;
+			}
+			if (query_profile) {
+				query_profile->cache_hits.fetch_add(1, std::memory_order_relaxed);
+			}
+			copy_overlap(chunk_data.get(), chunk_offset, length);
+		}
+		if (run_begin > last_chunk) {
+			continue;
+		}
+		// Fetch the run of missing chunks [run_begin, chunk) with one aligned GET and persist it.
+		auto run_offset = run_begin * chunk_size;
+		auto run_length = MinValue<idx_t>(chunk_offset, known_content_length) - run_offset;
+		auto run_data = make_unsafe_uniq_array_uninitialized<data_t>(run_length);
+		FetchRange(run_data.get(), run_length, run_offset);
+		for (auto missing = run_begin; missing < chunk; missing++) {
+			auto offset_in_run = (missing - run_begin) * chunk_size;
+			auto length = MinValue<idx_t>(chunk_size, run_length - offset_in_run);
+			disk_cache.WriteChunk(disk_cache_object_hash, missing, run_data.get() + offset_in_run, length);
+		}
+		copy_overlap(run_data.get(), run_offset, run_length);
+		run_begin = last_chunk + 1;
+	}
+}
+
+void S3RedirectFileHandle::ReadThroughBlockCache(void *buffer, idx_t nr_bytes, idx_t location) {
+	auto first_block = location / block_size;
+	auto last_block = (location + nr_bytes - 1) / block_size;
+	auto block_count = last_block - first_block + 1;
+
+	vector<shared_ptr<const S3RedirectBlock>> blocks(block_count);
+	idx_t hits = 0;
+	for (idx_t i = 0; i < block_count; i++) {
+		blocks[i] = block_cache.Get(object_key, block_size, first_block + i);
+		hits += blocks[i] ? 1 : 0;
+	}
+	if (query_profile) {
+		query_profile->cache_hits.fetch_add(hits, std::memory_order_relaxed);
+		query_profile->cache_misses.fetch_add(block_count - hits, std::memory_order_relaxed);
+	}
+	// One GET per run of consecutive missing blocks.
+	for (idx_t run_begin = 0; run_begin < block_count;) {
+		if (blocks[run_begin]) {
+			run_begin++;
+			continue;
+		}
+		auto run_end = run_begin;
+		while (run_end < block_count && !blocks[run_end]) {
+			run_end++;
+		}
+		auto run_offset = (first_block + run_begin) * block_size;
+		auto run_length = MinValue<idx_t>((first_block + run_end) * block_size, known_content_length) - run_offset;
+		auto run_data = make_unsafe_uniq_array_uninitialized<data_t>(run_length);
+		ReadRemote(run_data.get(), run_length, run_offset);
+		for (auto i = run_begin; i < run_end; i++) {
+			auto block_offset = (i - run_begin) * block_size;
+			auto size = MinValue<idx_t>(block_size, run_length - block_offset);
+			auto data = make_unsafe_uniq_array_uninitialized<data_t>(size);
+			memcpy(data.get(), run_data.get() + block_offset, size);
+			blocks[i] = make_shared_ptr<S3RedirectBlock>(std::move(data), size);
+			block_cache.Put(object_key, block_size, first_block + i, blocks[i]);
+		}
+		run_begin = run_end;
+	}
+
+	auto out = static_cast<data_ptr_t>(buffer);
+	for (idx_t i = 0; i < block_count; i++) {
+		auto block_start = (first_block + i) * block_size;
+		auto copy_begin = MaxValue<idx_t>(location, block_start);
+		auto copy_end = MinValue<idx_t>(location + nr_bytes, block_start + blocks[i]->size);
+		D_ASSERT(copy_end > copy_begin);
+		memcpy(out + (copy_begin - location), blocks[i]->data.get() + (copy_begin - block_start),
+		       copy_end - copy_begin);
+	}
 }
 
-// Sequential read: uses the primary handle (single-threaded sequential access path).
+// Sequential read: single-threaded cursor, served by the readahead engine when enabled.
 int64_t S3RedirectFileHandle::Read(void *buffer, idx_t nr_bytes) {
 	CWIQ_LOG_TRACE(db_instance, "Read: %s bytes (sequential)", std::to_string(nr_bytes));
-	return GetPrimaryHandle().Read(buffer, nr_bytes);
+	auto start = std::chrono::steady_clock::now();
+	auto bytes_read = ReadSequential(buffer, nr_bytes);
+	stats.Record(S3RedirectStats::Operation::SEQUENTIAL_READ, ElapsedMicros(start), idx_t(bytes_read));
+	if (query_profile) {
+		query_profile->reads.fetch_add(1, std::memory_order_relaxed);
+		query_profile->bytes_read.fetch_add(idx_t(bytes_read), std::memory_order_relaxed);
+	}
+	return bytes_read;
+}
+
+int64_t S3RedirectFileHandle::ReadSequential(void *buffer, idx_t nr_bytes) {
+	if (whole_object) {
+		auto remaining = known_content_length - MinValue<idx_t>(sequential_position, known_content_length);
+		auto length = MinValue<idx_t>(nr_bytes, remaining);
+		if (length == 0 || whole_object->TryRead(static_cast<data_ptr_t>(buffer), length, sequential_position)) {
+			sequential_position += length;
+			return int64_t(length);
+		}
+		// The download failed: read through the normal path. Seek() only moved sequential_position.
+		if (readahead_max_window == 0) {
+			GetPrimaryHandle().Seek(sequential_position);
+			auto bytes_read = GetPrimaryHandle().Read(buffer, nr_bytes);
+			sequential_position += idx_t(bytes_read);
+			return bytes_read;
+		}
+	}
+	if (readahead_max_window == 0) {
+		return GetPrimaryHandle().Read(buffer, nr_bytes);
+	}
+	if (!readahead) {
+		readahead = make_uniq<S3RedirectReadahead>(
+		    task_pool,
+		    [this](data_ptr_t target, idx_t length, idx_t offset) {
+			    if (local_handle) {
+				    ReadLocalFirst(target, length, offset, false);
+			    } else {
+				    ReadRemote(target, length, offset);
+			    }
+		    },
+		    known_content_length, readahead_initial_window, readahead_max_window);
+	}
+	auto bytes_read = readahead->Read(static_cast<data_ptr_t>(buffer), nr_bytes, sequential_position);
+	sequential_position += bytes_read;
+	return int64_t(bytes_read);
 }
 
 bool S3RedirectFileHandle::CanSeek() {
@@ -129,230 +773,597 @@ void S3RedirectFileHandle::Sync() {
 }
 
 FileType S3RedirectFileHandle::GetType() {
-	return GetPrimaryHandle().GetType();
+	// Redirected objects are always regular files; no need to open the primary handle.
+	return FileType::FILE_TYPE_REGULAR;
 }
 
 timestamp_t S3RedirectFileHandle::GetLastModifiedTime() {
 	return last_modified_time;
 }
 
-void S3RedirectFileHandle::Write(void *buffer, idx_t nr_bytes, idx_t location) {
-	GetPrimaryHandle().Write(buffer, nr_bytes);
+// ---------------------------------------------------------------------------
+// S3RedirectWriteHandle
+// ---------------------------------------------------------------------------
+
+S3RedirectWriteHandle::S3RedirectWriteHandle(S3RedirectProtocolFileSystem &fs, const string &path,
+                                             FileOpenFlags flags, unique_ptr<FileHandle> local_handle_p,
+                                             idx_t buffer_size)
+    : S3RedirectHandle(fs, path, flags), local_fs(fs.GetLocalFileSystem()), local_handle(std::move(local_handle_p)),
+      write_buffer(
+          fs.GetTaskPool(),
+          [this](const_data_ptr_t data, idx_t nr_bytes, idx_t location) {
+	          // pwrite on the mount: safe from a pool thread while the writer keeps filling.
+	          local_fs.Write(*local_handle, const_cast<data_ptr_t>(data), int64_t(nr_bytes), location);
+          },
+          buffer_size) {
+}
+
+S3RedirectWriteHandle::~S3RedirectWriteHandle() {
+	try {
+		Close();
+	} catch (...) {
+	}
+}
+
+void S3RedirectWriteHandle::Close() {
+	std::lock_guard<std::mutex> lk(lock);
+	if (!local_handle) {
+		return;
+	}
+	write_buffer.Flush();
+	local_handle->Close();
+	local_handle.reset();
+}
+
+void S3RedirectWriteHandle::Write(void *buffer, idx_t nr_bytes, idx_t location) {
+	std::lock_guard<std::mutex> lk(lock);
+	write_buffer.Write(static_cast<const_data_ptr_t>(buffer), nr_bytes, location);
+	position = location + nr_bytes;
+}
+
+int64_t S3RedirectWriteHandle::Write(void *buffer, idx_t nr_bytes) {
+	std::lock_guard<std::mutex> lk(lock);
+	write_buffer.Write(static_cast<const_data_ptr_t>(buffer), nr_bytes, position);
+	position += nr_bytes;
+	return int64_t(nr_bytes);
+}
+
+void S3RedirectWriteHandle::Read(void *buffer, idx_t nr_bytes, idx_t location) {
+	std::lock_guard<std::mutex> lk(lock);
+	write_buffer.Flush();
+	local_fs.Read(*local_handle, buffer, int64_t(nr_bytes), location);
+	position = location + nr_bytes;
+}
+
+int64_t S3RedirectWriteHandle::Read(void *buffer, idx_t nr_bytes) {
+	std::lock_guard<std::mutex> lk(lock);
+	write_buffer.Flush();
+	local_fs.Seek(*local_handle, position);
+	auto bytes_read = local_fs.Read(*local_handle, buffer, int64_t(nr_bytes));
+	position += idx_t(bytes_read);
+	return bytes_read;
+}
+
+void S3RedirectWriteHandle::Seek(idx_t location) {
+	std::lock_guard<std::mutex> lk(lock);
+	position = location;
 }
 
-int64_t S3RedirectFileHandle::Write(void *buffer, idx_t nr_bytes) {
-	return GetPrimaryHandle().Write(buffer, nr_bytes);
+idx_t S3RedirectWriteHandle::SeekPosition() {
+	std::lock_guard<std::mutex> lk(lock);
+	return position;
 }
 
-void S3RedirectFileHandle::Truncate(int64_t new_size) {
-	return GetPrimaryHandle().Truncate(new_size);
+idx_t S3RedirectWriteHandle::GetFileSize() {
+	std::lock_guard<std::mutex> lk(lock);
+	// Buffered writes past the end grow the file too; no need to flush for that.
+	return MaxValue<idx_t>(idx_t(local_fs.GetFileSize(*local_handle)), write_buffer.BufferedEnd());
+}
+
+timestamp_t S3RedirectWriteHandle::GetLastModifiedTime() {
+	std::lock_guard<std::mutex> lk(lock);
+	write_buffer.Flush();
+	return local_fs.GetLastModifiedTime(*local_handle);
+}
+
+FileType S3RedirectWriteHandle::GetType() {
+	std::lock_guard<std::mutex> lk(lock);
+	return local_fs.GetFileType(*local_handle);
+}
+
+void S3RedirectWriteHandle::Sync() {
+	std::lock_guard<std::mutex> lk(lock);
+	write_buffer.Flush();
+	local_fs.FileSync(*local_handle);
+}
+
+void S3RedirectWriteHandle::Truncate(int64_t new_size) {
+	std::lock_guard<std::mutex> lk(lock);
+	write_buffer.Flush();
+	local_fs.Truncate(*local_handle, new_size);
 }
 
 // ---------------------------------------------------------------------------
 // S3RedirectProtocolFileSystem
 // ---------------------------------------------------------------------------
 
+S3RedirectProtocolFileSystem::S3RedirectProtocolFileSystem(DatabaseInstance &db) : db_instance(db) {
+}
+
 unique_ptr<FileHandle> S3RedirectProtocolFileSystem::OpenFile(const string &path, FileOpenFlags flags,
                                                               optional_ptr<FileOpener> opener) {
 	// Writes are not redirectable — the S3 target is read-only. Fall back to the real
-	// on-disk file on the CWIQ FS mount so the kernel/mount handles persistence. The
-	// returned handle references local_fs, so all later ops bypass this FS entirely
-	// (including the read side of a READ|WRITE open).
+	// on-disk file on the CWIQ FS mount so the kernel/mount handles persistence. Unless the
+	// write is buffered, the returned handle references local_fs, so all later ops bypass this
+	// FS entirely (including the read side of a READ|WRITE open).
 	if (flags.OpenForWriting()) {
-		CWIQ_LOG_DEBUG(db_instance, "OpenFile: %s opened for writing, falling back to local FS", path);
+		auto local_handle = local_fs.OpenFile(path, flags, opener);
+		// Direct I/O needs aligned user buffers and append mode ignores write offsets, so both
+		// keep the plain handle. So do read-write opens (database files, WALs): they are read back
+		// while being written, from several threads, and every read would have to flush first.
+		if (!local_handle || flags.OpenForReading() || flags.DirectIO() || flags.OpenForAppending() ||
+		    !IsBufferedWritePath(path)) {
+			CWIQ_LOG_DEBUG(db_instance, "OpenFile: %s opened for writing, falling back to local FS", path);
+			return local_handle;
+		}
+		auto buffer_size = write_buffer_size.load(std::memory_order_relaxed);
+		CWIQ_LOG_DEBUG(db_instance, "OpenFile: %s opened for writing, buffering %s bytes per write", path,
+		               std::to_string(buffer_size));
+		return make_uniq<S3RedirectWriteHandle>(*this, path, flags, std::move(local_handle), buffer_size);
+	}
+	auto settings = S3RedirectSettings::Fetch(db_instance);
+	resolution_cache.SetCapacity(settings.resolution_cache_entries);
+	handle_pool.SetLimits(settings.pool_max_handles_per_object, settings.pool_max_handles,
+	                      settings.pool_target_handles, settings.pool_idle_timeout_ms);
+	block_cache.SetCapacity(settings.block_cache_size);
+	auto disk_cache_error = disk_cache.Configure(settings.disk_cache_path, settings.disk_cache_size);
+	if (!disk_cache_error.empty()) {
+		CWIQ_LOG_WARN(db_instance, "OpenFile: disk cache disabled: %s", disk_cache_error);
+	}
+	task_pool.SetMaxThreads(settings.io_threads);
+	hedging.Configure(settings.hedged_reads, settings.hedge_percentile, settings.hedge_max_ratio,
+	                  settings.hedge_min_delay_ms);
+	io_scheduler.Configure(settings.max_in_flight, settings.max_in_flight_per_endpoint);
+	auto start = std::chrono::steady_clock::now();
+	auto resolution = Resolve(path, settings.local_first, settings.seed_http_metadata);
+	if (!resolution.IsRedirectable() && IsBufferedWritePath(path)) {
+		// Claimed by CanHandleFile for its writes only; reading it is a plain local read.
 		return local_fs.OpenFile(path, flags, opener);
 	}
 	try {
-		auto s3_info = ConvertLocalPathToS3(path);
-		CWIQ_LOG_INFO(db_instance, "OpenFile: redirecting %s to S3", path);
-		return make_uniq<S3RedirectFileHandle>(*this, db_instance, s3_info.s3_url, s3_info.content_length,
-		                                       s3_info.last_modified_time, opener);
+		if (!resolution.IsRedirectable()) {
+			resolution.ThrowError(path);
+		}
+		EnsureHttpfsLoaded();
+		auto s3_info = std::move(resolution.info);
+		auto object_key = s3_info.ObjectKey();
+		if (s3_info.residency && !s3_info.residency->Empty()) {
+			CWIQ_LOG_INFO(db_instance, "OpenFile: redirecting %s to S3, %s resident ranges read locally", path,
+			              std::to_string(s3_info.residency->ranges.size()));
+		} else {
+			CWIQ_LOG_INFO(db_instance, "OpenFile: redirecting %s to S3", path);
+		}
+		auto handle = make_uniq<S3RedirectFileHandle>(*this, db_instance, s3_info.s3_url, s3_info.content_length,
+		                                              s3_info.last_modified_time, std::move(s3_info.etag),
+		                                              std::move(object_key), opener, settings, path,
+		                                              std::move(s3_info.residency));
+		stats.Record(S3RedirectStats::Operation::OPEN, ElapsedMicros(start));
+		return std::move(handle);
 	} catch (const std::exception &e) {
 		throw IOException("Failed to redirect to S3: " + string(e.what()));
 	}
 }
 
-bool S3RedirectProtocolFileSystem::FileExists(const string &filename, optional_ptr<FileOpener> opener) {
-	try {
-		ConvertLocalPathToS3(filename);
-		return true;
-	} catch (...) {
+void S3RedirectProtocolFileSystem::EnsureHttpfsLoaded() {
+	if (httpfs_loaded.load(std::memory_order_acquire)) {
+		return;
+	}
+	// Concurrent first opens wait for one load; a failed load is retried by the next open.
+	std::lock_guard<std::mutex> lk(httpfs_load_lock);
+	if (httpfs_loaded.load(std::memory_order_relaxed)) {
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	// Honours autoload_known_extensions / autoinstall_known_extensions like any other autoload.
+	if (!db_instance.ExtensionIsLoaded("httpfs") && !ExtensionHelper::TryAutoLoadExtension(db_instance, "httpfs")) {
+		throw IOException("the httpfs extension is required to read redirected files; run INSTALL httpfs and "
+		                  "LOAD httpfs, or enable autoinstall_known_extensions");
+	}
+	CWIQ_LOG_DEBUG(db_instance, "EnsureHttpfsLoaded: httpfs ready after %s us",
+	               std::to_string(ElapsedMicros(start)));
+	httpfs_loaded.store(true, std::memory_order_release);
+}
+
+void S3RedirectProtocolFileSystem::RefreshPathSettings() {
+	auto generation = S3RedirectSettings::GetPathSettingsGeneration();
+	if (generation == path_settings_generation.load(std::memory_order_acquire)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lk(path_settings_lock);
+	// Read before the options: a SET landing in between bumps it again and the next call re-reads.
+	generation = S3RedirectSettings::GetPathSettingsGeneration();
+	if (generation == path_settings_generation.load(std::memory_order_relaxed)) {
+		return;
+	}
+	S3RedirectSettings settings;
+	S3RedirectSettings::FetchPathSettings(db_instance, settings);
+	resolution_cache.SetResolver(settings.resolver, settings.manifest_path, settings.xattr_namespace);
+	write_buffer_size.store(settings.write_buffer_size, std::memory_order_relaxed);
+	mount_table.Configure(settings.mount_filesystem_type, settings.GetMountPaths());
+	path_settings_generation.store(generation, std::memory_order_release);
+}
+
+S3RedirectResolution S3RedirectProtocolFileSystem::Resolve(const string &local_path, bool probe_residency,
+                                                           bool probe_etag) {
+	auto start = std::chrono::steady_clock::now();
+	// On every resolution: CanHandleFile runs before any OpenFile that could configure it.
+	RefreshPathSettings();
+	auto resolution = resolution_cache.Resolve(local_path, probe_residency, probe_etag);
+	stats.Record(S3RedirectStats::Operation::RESOLVE, ElapsedMicros(start));
+	return resolution;
+}
+
+S3RedirectInfo S3RedirectProtocolFileSystem::ResolvePath(const string &local_path, bool probe_residency) {
+	auto resolution = Resolve(local_path, probe_residency);
+	if (!resolution.IsRedirectable()) {
+		resolution.ThrowError(local_path);
+	}
+	return std::move(resolution.info);
+}
+
+bool S3RedirectProtocolFileSystem::IsBufferedWritePath(const string &path) {
+	RefreshPathSettings();
+	if (write_buffer_size.load(std::memory_order_relaxed) == 0) {
 		return false;
 	}
+	// s3://, http:// and other schemes never live on a mount.
+	return !StringUtil::Contains(path, "://") && mount_table.IsCwiqfsPath(path);
+}
+
+bool S3RedirectProtocolFileSystem::FileExists(const string &filename, optional_ptr<FileOpener> opener) {
+	// Plain files on the mount are only routed here while write buffering claims the mount.
+	return Resolve(filename).IsRedirectable() || local_fs.FileExists(filename, opener);
 }
 
 bool S3RedirectProtocolFileSystem::CanHandleFile(const string &fpath) {
 #ifdef __linux__
 	if (StringUtil::StartsWith(fpath, "http")) // Check if file is already a URL
 		return false;
+	// Other schemes (s3://, gs://, ...) are not local paths either: no stat, no mount lookup.
+	if (StringUtil::Contains(fpath, "://")) {
+		return false;
+	}
 
-	// Check if file is in CWIQFS
-	const char *xattr_name = "system.cwiqfs.s3_url";
-	ssize_t size = getxattr(fpath.c_str(), xattr_name, nullptr, 0);
-	return size > 0;
+	// The VFS routes a glob by its pattern, which never resolves itself: claim patterns on the
+	// mount so Glob() gets to resolve the matches.
+	if (FileSystem::HasGlob(fpath)) {
+		RefreshPathSettings();
+		return mount_table.IsCwiqfsPath(fpath);
+	}
+	// Check if file is in CWIQFS (served from the resolution cache while the file is unchanged)
+	auto resolution = Resolve(fpath);
+	CWIQ_LOG_TRACE(db_instance, "CanHandleFile: %s redirectable=%s (resolution cache hits=%s misses=%s)", fpath,
+	               resolution.IsRedirectable() ? "true" : "false", std::to_string(resolution_cache.GetHits()),
+	               std::to_string(resolution_cache.GetMisses()));
+	if (resolution.IsRedirectable()) {
+		return true;
+	}
+	// The rest of the mount too, so writes to it (new files included) get a buffered handle.
+	return IsBufferedWritePath(fpath);
 #else
 	return false;
 #endif
 }
 
-// Positional read: delegates to S3RedirectFileHandle::Read(buf,n,loc) which
-// borrows an exclusive pool handle — no shared mutable state between callers.
+// Positional read: S3RedirectFileHandle::Read(buf,n,loc) borrows an exclusive pool handle — no
+// shared mutable state between callers. Only handles opened by this filesystem reach it, so the
+// cast is static and the handle type is dispatched virtually.
 void S3RedirectProtocolFileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) {
-	auto *h = dynamic_cast<S3RedirectFileHandle *>(&handle);
-	if (h) {
-		return h->Read(buffer, nr_bytes, location);
-	}
-	throw InternalException("Invalid handle type in S3RedirectProtocolFileSystem");
+	handle.Cast<S3RedirectHandle>().Read(buffer, nr_bytes, location);
 }
 
-// Sequential read: uses the primary handle.
+// Sequential read: readahead, or the primary handle.
 int64_t S3RedirectProtocolFileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes) {
-	auto *h = dynamic_cast<S3RedirectFileHandle *>(&handle);
-	if (h) {
-		return h->Read(buffer, nr_bytes);
-	}
-	throw InternalException("Invalid handle type in S3RedirectProtocolFileSystem");
+	return handle.Cast<S3RedirectHandle>().Read(buffer, nr_bytes);
 }
 
 void S3RedirectProtocolFileSystem::Seek(FileHandle &handle, idx_t location) {
-	auto *h = dynamic_cast<S3RedirectFileHandle *>(&handle);
-	if (h) {
-		return h->GetPrimaryHandle().Seek(location);
-	}
-	throw InternalException("Invalid handle type in S3RedirectProtocolFileSystem");
+	handle.Cast<S3RedirectHandle>().Seek(location);
 }
 
 idx_t S3RedirectProtocolFileSystem::SeekPosition(FileHandle &handle) {
-	auto *h = dynamic_cast<S3RedirectFileHandle *>(&handle);
-	if (h) {
-		return h->GetPrimaryHandle().SeekPosition();
-	}
-	throw InternalException("Invalid handle type in S3RedirectProtocolFileSystem");
+	return handle.Cast<S3RedirectHandle>().SeekPosition();
 }
 
 int64_t S3RedirectProtocolFileSystem::GetFileSize(FileHandle &handle) {
-	auto *h = dynamic_cast<S3RedirectFileHandle *>(&handle);
-	if (h) {
-		return h->GetFileSize();
-	}
-	throw InternalException("Invalid handle type in S3RedirectProtocolFileSystem");
+	return handle.Cast<S3RedirectHandle>().GetFileSize();
 }
 
 FileType S3RedirectProtocolFileSystem::GetFileType(FileHandle &handle) {
-	return FileType::FILE_TYPE_REGULAR;
+	return handle.Cast<S3RedirectHandle>().GetType();
 }
 
 void S3RedirectProtocolFileSystem::FileSync(FileHandle &handle) {
-	if (auto *h = dynamic_cast<S3RedirectFileHandle *>(&handle)) {
-		h->Sync();
-	}
+	handle.Cast<S3RedirectHandle>().Sync();
+}
+
+bool S3RedirectProtocolFileSystem::OnDiskFile(FileHandle &handle) {
+	return handle.Cast<S3RedirectHandle>().IsOnDisk();
+}
+
+void S3RedirectProtocolFileSystem::Write(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) {
+	handle.Cast<S3RedirectHandle>().Write(buffer, nr_bytes, location);
+}
+
+int64_t S3RedirectProtocolFileSystem::Write(FileHandle &handle, void *buffer, int64_t nr_bytes) {
+	return handle.Cast<S3RedirectHandle>().Write(buffer, nr_bytes);
+}
+
+void S3RedirectProtocolFileSystem::Truncate(FileHandle &handle, int64_t new_size) {
+	handle.Cast<S3RedirectHandle>().Truncate(new_size);
 }
 
 timestamp_t S3RedirectProtocolFileSystem::GetLastModifiedTime(FileHandle &handle) {
-	auto *h = dynamic_cast<S3RedirectFileHandle *>(&handle);
-	if (h) {
-		return h->GetLastModifiedTime();
-	}
-	throw InternalException("Invalid handle type in S3RedirectProtocolFileSystem");
+	return handle.Cast<S3RedirectHandle>().GetLastModifiedTime();
 }
 
 vector<OpenFileInfo> S3RedirectProtocolFileSystem::Glob(const string &path, FileOpener *opener) {
-	return local_fs.Glob(path, nullptr);
+	auto matches = local_fs.Glob(path, nullptr);
+	if (matches.empty()) {
+		return matches;
+	}
+	// Resolve every match up front on the I/O pool: the stat + getxattr round trips into the
+	// CWIQ FS daemon overlap instead of being paid one by one as the scan opens each file, and the
+	// resolution cache is primed so those opens hit it.
+	auto settings = S3RedirectSettings::Fetch(db_instance);
+	resolution_cache.SetCapacity(settings.resolution_cache_entries);
+	task_pool.SetMaxThreads(settings.io_threads);
+	std::atomic<idx_t> redirected {0};
+	task_pool.ParallelFor(matches.size(), settings.glob_threads, [&](idx_t i) {
+		auto &match = matches[i];
+		auto resolution = Resolve(match.path);
+		if (!resolution.IsRedirectable()) {
+			return;
+		}
+		// Same option names httpfs uses for its own glob results; readers use them instead of
+		// asking for the size and mtime again.
+		if (!match.extended_info) {
+			match.extended_info = make_shared_ptr<ExtendedOpenFileInfo>();
+		}
+		auto &options = match.extended_info->options;
+		options["file_size"] = Value::UBIGINT(resolution.info.content_length);
+		options["last_modified"] = Value::TIMESTAMP(resolution.info.last_modified_time);
+		redirected.fetch_add(1, std::memory_order_relaxed);
+	});
+	CWIQ_LOG_DEBUG(db_instance, "Glob: %s matched %s files, %s redirectable", path, std::to_string(matches.size()),
+	               std::to_string(redirected.load()));
+	return matches;
+}
+
+S3RedirectStats::counter_list_t S3RedirectProtocolFileSystem::CollectCounters() {
+	return {
+	    {"resolution_cache_hits", resolution_cache.GetHits()},
+	    {"xattr_lookups", resolution_cache.GetMisses()},
+	    {"pool_hits", handle_pool.GetHits()},
+	    {"pool_misses", handle_pool.GetMisses()},
+	    {"pool_reaped", handle_pool.GetReaped()},
+	    {"block_cache_hits", block_cache.GetHits()},
+	    {"block_cache_misses", block_cache.GetMisses()},
+	    {"block_cache_evictions", block_cache.GetEvictions()},
+	    {"disk_cache_hits", disk_cache.GetHits()},
+	    {"disk_cache_misses", disk_cache.GetMisses()},
+	    {"single_flight_shared", single_flight.GetShared()},
+	    {"hedges_sent", hedging.GetHedgesSent()},
+	    {"hedges_won", hedging.GetHedgesWon()},
+	    {"io_queued_requests", io_scheduler.GetQueuedRequests()},
+	    {"io_queue_wait_us", io_scheduler.GetWaitMicros()},
+	    {"io_throttle_events", io_scheduler.GetThrottleEvents()},
+	};
+}
+
+vector<S3RedirectStatRow> S3RedirectProtocolFileSystem::SnapshotStats() {
+	S3RedirectStats::counter_list_t gauges {
+	    {"block_cache_size_bytes", block_cache.GetSizeBytes()},
+	    {"disk_cache_size_bytes", disk_cache.GetSizeBytes()},
+	    {"pool_idle_handles", handle_pool.GetIdleCount()},
+	    {"pool_idle_bytes", handle_pool.GetIdleBytes()},
+	    {"io_queue_depth", io_scheduler.GetQueueDepth()},
+	    {"io_in_flight", io_scheduler.GetInFlight()},
+	};
+	return stats.Snapshot(CollectCounters(), gauges);
+}
+
+void S3RedirectProtocolFileSystem::ResetStats() {
+	stats.Reset(CollectCounters());
 }
 
 // ---------------------------------------------------------------------------
 // ConvertLocalPathToS3
 // ---------------------------------------------------------------------------
 
+// Uncached: callers inside the filesystem go through S3RedirectProtocolFileSystem::ResolvePath.
 S3RedirectInfo ConvertLocalPathToS3(const string &local_path) {
-#ifndef __linux__
-	throw IOException("Failed to read xattr value for " + local_path + ": " + strerror(errno));
+	auto resolution = S3RedirectResolutionCache::ResolveUncached(local_path);
+	if (!resolution.IsRedirectable()) {
+		resolution.ThrowError(local_path);
+	}
+	return std::move(resolution.info);
+}
+
+// ---------------------------------------------------------------------------
+// Extension entry points
+// ---------------------------------------------------------------------------
+
+std::string CwiqduckExtension::Name() {
+	return "cwiqduck";
+}
+
+std::string CwiqduckExtension::Version() const {
+#ifdef EXT_VERSION_CWIQDUCK
+	return EXT_VERSION_CWIQDUCK;
 #else
-	S3RedirectInfo info;
-	const char *xattr_name = "system.cwiqfs.s3_url";
-	ssize_t size = getxattr(local_path.c_str(), xattr_name, nullptr, 0);
+	return "";
+#endif
+}
 
-	if (size < 0) {
-		int err = errno;
-		string error_msg = "Failed to get xattr '" + string(xattr_name) + "' for " + local_path + ": ";
+// ---------------------------------------------------------------------------
+// cwiqduck_stats() / cwiqduck_stats_reset()
+// ---------------------------------------------------------------------------
 
-		switch (err) {
-		case ENODATA:
-			error_msg += "attribute does not exist";
-			break;
-		case ENOENT:
-			error_msg += "file does not exist";
-			break;
-		case EACCES:
-			error_msg += "permission denied";
-			break;
-		case ENOTSUP:
-			error_msg += "xattrs not supported on this filesystem";
-			break;
-		default:
-			error_msg += strerror(err);
-		}
-		throw IOException(error_msg);
+// Carries the filesystem instance of this database into the table functions.
+struct CwiqduckStatsFunctionInfo : public TableFunctionInfo {
+	explicit CwiqduckStatsFunctionInfo(S3RedirectProtocolFileSystem &fs_p) : fs(fs_p) {
 	}
+	S3RedirectProtocolFileSystem &fs;
+};
 
-	if (size == 0) {
-		throw IOException("Empty xattr value for " + local_path);
+struct CwiqduckStatsBindData : public TableFunctionData {
+	explicit CwiqduckStatsBindData(S3RedirectProtocolFileSystem &fs_p) : fs(fs_p) {
 	}
+	S3RedirectProtocolFileSystem &fs;
+};
+
+struct CwiqduckStatsState : public GlobalTableFunctionState {
+	vector<S3RedirectStatRow> rows;
+	idx_t offset = 0;
+	bool finished = false;
+};
+
+static unique_ptr<FunctionData> CwiqduckStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                  vector<LogicalType> &return_types, vector<string> &names) {
+	names = {"name", "value", "bytes", "p50_us", "p99_us"};
+	return_types = {LogicalType::VARCHAR, LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::DOUBLE,
+	                LogicalType::DOUBLE};
+	return make_uniq<CwiqduckStatsBindData>(input.info->Cast<CwiqduckStatsFunctionInfo>().fs);
+}
 
-	vector<char> buffer(size);
-	ssize_t actual_size = getxattr(local_path.c_str(), xattr_name, buffer.data(), size);
+static unique_ptr<GlobalTableFunctionState> CwiqduckStatsInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<CwiqduckStatsState>();
+	state->rows = input.bind_data->Cast<CwiqduckStatsBindData>().fs.SnapshotStats();
+	return std::move(state);
+}
 
-	if (actual_size < 0) {
-		throw IOException("Failed to read xattr value for " + local_path + ": " + strerror(errno));
+// One row per operation (value = count, with bytes and latency percentiles) and per counter or
+// gauge (value only).
+static void CwiqduckStatsFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<CwiqduckStatsState>();
+	idx_t count = 0;
+	while (state.offset < state.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = state.rows[state.offset++];
+		output.SetValue(0, count, Value(row.name));
+		output.SetValue(1, count, Value::UBIGINT(row.value));
+		output.SetValue(2, count, row.is_operation ? Value::UBIGINT(row.bytes) : Value());
+		output.SetValue(3, count, row.is_operation ? Value::DOUBLE(row.p50_us) : Value());
+		output.SetValue(4, count, row.is_operation ? Value::DOUBLE(row.p99_us) : Value());
+		count++;
 	}
+	output.SetCardinality(count);
+}
+
+static unique_ptr<FunctionData> CwiqduckStatsResetBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+	names = {"success"};
+	return_types = {LogicalType::BOOLEAN};
+	return make_uniq<CwiqduckStatsBindData>(input.info->Cast<CwiqduckStatsFunctionInfo>().fs);
+}
 
-	// Convert to string (xattr values may not be null-terminated)
-	info.s3_url = string(buffer.data(), actual_size);
-	struct stat st;
-	if (stat(local_path.c_str(), &st) != 0) {
-		throw IOException("Failed to stat file " + local_path + ": " + strerror(errno));
+static unique_ptr<GlobalTableFunctionState> CwiqduckStatsResetInit(ClientContext &context,
+                                                                   TableFunctionInitInput &input) {
+	return make_uniq<CwiqduckStatsState>();
+}
+
+static void CwiqduckStatsResetFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<CwiqduckStatsState>();
+	if (state.finished) {
+		output.SetCardinality(0);
+		return;
 	}
+	data.bind_data->Cast<CwiqduckStatsBindData>().fs.ResetStats();
+	state.finished = true;
+	output.SetValue(0, 0, Value::BOOLEAN(true));
+	output.SetCardinality(1);
+}
 
-	info.content_length = st.st_size;
-	info.last_modified_time = st.st_mtime;
+static void RegisterStatsFunctions(ExtensionLoader &loader, S3RedirectProtocolFileSystem &fs) {
+	auto info = make_shared_ptr<CwiqduckStatsFunctionInfo>(fs);
 
-	return info;
-#endif
+	TableFunction stats_function("cwiqduck_stats", {}, CwiqduckStatsFunction, CwiqduckStatsBind, CwiqduckStatsInit);
+	stats_function.function_info = info;
+	loader.RegisterFunction(stats_function);
+
+	TableFunction reset_function("cwiqduck_stats_reset", {}, CwiqduckStatsResetFunction, CwiqduckStatsResetBind,
+	                             CwiqduckStatsResetInit);
+	reset_function.function_info = info;
+	loader.RegisterFunction(reset_function);
 }
 
 // ---------------------------------------------------------------------------
-// Extension entry points
+// cwiqduck_query_profile()
 // ---------------------------------------------------------------------------
 
-std::string CwiqduckExtension::Name() {
-	return "cwiqduck";
+struct CwiqduckQueryProfileState : public GlobalTableFunctionState {
+	vector<S3RedirectFileProfileRow> rows;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> CwiqduckQueryProfileBind(ClientContext &context, TableFunctionBindInput &input,
+                                                         vector<LogicalType> &return_types, vector<string> &names) {
+	names = {"path",          "reads",      "bytes_read",   "requests",    "request_bytes",  "request_us",
+	         "queue_wait_us", "cache_hits", "cache_misses", "local_bytes", "cache_hit_ratio"};
+	return_types = {LogicalType::VARCHAR, LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::UBIGINT,
+	                LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::UBIGINT,
+	                LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::DOUBLE};
+	return make_uniq<TableFunctionData>();
 }
 
-std::string CwiqduckExtension::Version() const {
-#ifdef EXT_VERSION_CWIQDUCK
-	return EXT_VERSION_CWIQDUCK;
-#else
-	return "";
-#endif
+static unique_ptr<GlobalTableFunctionState> CwiqduckQueryProfileInit(ClientContext &context,
+                                                                     TableFunctionInitInput &input) {
+	auto state = make_uniq<CwiqduckQueryProfileState>();
+	auto profile = context.registered_state->Get<S3RedirectQueryProfile>(S3RedirectQueryProfile::STATE_KEY);
+	if (profile) {
+		state->rows = profile->GetLastQuery();
+	}
+	return std::move(state);
 }
 
-static void LoadInternal(DatabaseInstance &db) {
+// Per-file I/O of the previous query on this connection.
+static void CwiqduckQueryProfileFunction(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<CwiqduckQueryProfileState>();
+	idx_t count = 0;
+	while (state.offset < state.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = state.rows[state.offset++];
+		auto ratio = row.CacheHitRatio();
+		output.SetValue(0, count, Value(row.path));
+		output.SetValue(1, count, Value::UBIGINT(row.reads));
+		output.SetValue(2, count, Value::UBIGINT(row.bytes_read));
+		output.SetValue(3, count, Value::UBIGINT(row.requests));
+		output.SetValue(4, count, Value::UBIGINT(row.request_bytes));
+		output.SetValue(5, count, Value::UBIGINT(row.request_micros));
+		output.SetValue(6, count, Value::UBIGINT(row.queue_wait_micros));
+		output.SetValue(7, count, Value::UBIGINT(row.cache_hits));
+		output.SetValue(8, count, Value::UBIGINT(row.cache_misses));
+		output.SetValue(9, count, Value::UBIGINT(row.local_bytes));
+		output.SetValue(10, count, std::isnan(ratio) ? Value() : Value::DOUBLE(ratio));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+static void RegisterQueryProfileFunction(ExtensionLoader &loader) {
+	TableFunction profile_function("cwiqduck_query_profile", {}, CwiqduckQueryProfileFunction,
+	                               CwiqduckQueryProfileBind, CwiqduckQueryProfileInit);
+	loader.RegisterFunction(profile_function);
+}
+
+static void LoadInternal(ExtensionLoader &loader) {
+	auto &db = loader.GetDatabaseInstance();
 #ifndef __linux__
-	std::cout << "Error: cwiqduck extension not implemented for non-Linux platforms.";
+	// CWIQ FS only exists on Linux; elsewhere the extension loads but redirects nothing.
 	return;
 #endif
 
-	// Force load httpfs first
-	Connection con(db);
-	auto result = con.Query("LOAD httpfs");
-	if (result->HasError()) {
-		std::cout << "Warning: Could not load httpfs: " << result->GetError() << std::endl;
-		// Try to install and load
-		con.Query("INSTALL httpfs");
-		con.Query("LOAD httpfs");
-	}
-
-	std::cout << "cwiqduck extension enabled" << std::endl;
+	// httpfs is not loaded here: processes that never open a CWIQ FS file should not pay for it.
+	// The first redirected OpenFile loads it (see EnsureHttpfsLoaded).
 
 	// Register our native log type so users can scope logging via `CALL enable_logging('cwiqduck')`
 	// and filter duckdb_logs by log_type. RegisterLogType throws on a duplicate (e.g. reload), so
@@ -363,20 +1374,25 @@ static void LoadInternal(DatabaseInstance &db) {
 		// Already registered — nothing to do.
 	}
 
+	S3RedirectSettings::Register(DBConfig::GetConfig(db));
+
 	auto s3_redirect_fs = make_uniq<S3RedirectProtocolFileSystem>(db);
+	// The virtual filesystem owns the instance for the database's lifetime.
+	RegisterStatsFunctions(loader, *s3_redirect_fs);
+	RegisterQueryProfileFunction(loader);
 
 	// Register the filesystem with DuckDB for the s3redirect:// protocol
 	db.GetFileSystem().RegisterSubSystem(std::move(s3_redirect_fs));
 }
 
 void CwiqduckExtension::Load(ExtensionLoader &loader) {
-	LoadInternal(loader.GetDatabaseInstance());
+	LoadInternal(loader);
 }
 } // namespace duckdb
 
 extern "C" {
 DUCKDB_CPP_EXTENSION_ENTRY(cwiqduck, loader) {
-	duckdb::LoadInternal(loader.GetDatabaseInstance());
+	duckdb::LoadInternal(loader);
 }
 }
 
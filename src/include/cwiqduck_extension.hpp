@@ -3,9 +3,23 @@
 #include "duckdb.hpp"
 #include "duckdb/common/local_file_system.hpp"
 #include "duckdb/logging/logger.hpp"
+#include "s3redirect_block_cache.hpp"
+#include "s3redirect_disk_cache.hpp"
+#include "s3redirect_handle_pool.hpp"
+#include "s3redirect_hedging.hpp"
+#include "s3redirect_io_scheduler.hpp"
+#include "s3redirect_mount_table.hpp"
+#include "s3redirect_prefetcher.hpp"
+#include "s3redirect_query_profile.hpp"
+#include "s3redirect_read_coalescer.hpp"
+#include "s3redirect_readahead.hpp"
+#include "s3redirect_resolution_cache.hpp"
+#include "s3redirect_settings.hpp"
+#include "s3redirect_single_flight.hpp"
+#include "s3redirect_stats.hpp"
+#include "s3redirect_task_pool.hpp"
+#include "s3redirect_write_buffer.hpp"
 
-#include <mutex>
-#include <vector>
 
 #undef MoveFile
 #undef RemoveDirectory
@@ -26,7 +40,10 @@ public:
 };
 
 // Level-specific loggers that keep log_type = "cwiqduck". A LogType carries a single LEVEL,
-// so we go through DUCKDB_LOG_INTERNAL directly to vary the level per call site.
+// so we go through DUCKDB_LOG_INTERNAL directly to vary the level per call site. The format
+// arguments are only evaluated once the level is known to be enabled, so std::to_string and the
+// like belong inside the macro call, never in a local computed ahead of it.
+#define CWIQ_LOG_WARN(SRC, ...)  DUCKDB_LOG_INTERNAL(SRC, CwiqduckLogType::NAME, LogLevel::LOG_WARN, __VA_ARGS__)
 #define CWIQ_LOG_INFO(SRC, ...)  DUCKDB_LOG_INTERNAL(SRC, CwiqduckLogType::NAME, LogLevel::LOG_INFO, __VA_ARGS__)
 #define CWIQ_LOG_DEBUG(SRC, ...) DUCKDB_LOG_INTERNAL(SRC, CwiqduckLogType::NAME, LogLevel::LOG_DEBUG, __VA_ARGS__)
 #define CWIQ_LOG_TRACE(SRC, ...) DUCKDB_LOG_INTERNAL(SRC, CwiqduckLogType::NAME, LogLevel::LOG_TRACE, __VA_ARGS__)
@@ -38,16 +55,46 @@ public:
 	std::string Version() const override;
 };
 
-struct S3RedirectInfo {
-	string s3_url;
-	idx_t content_length {0};
-	timestamp_t last_modified_time;
-};
-
 S3RedirectInfo ConvertLocalPathToS3(const string &local_path);
 
-class S3RedirectFileHandle : public FileHandle {
+class S3RedirectProtocolFileSystem;
+
+// Every handle S3RedirectProtocolFileSystem opens. The concrete type is chosen once in OpenFile,
+// so the FileSystem entry points cast statically and dispatch with one virtual call instead of
+// probing the type on every read. Writes and truncation are only supported by write handles.
+class S3RedirectHandle : public FileHandle {
+public:
+	S3RedirectHandle(FileSystem &fs, const string &path, FileOpenFlags flags) : FileHandle(fs, path, flags) {
+	}
+
+	virtual void Read(void *buffer, idx_t nr_bytes, idx_t location) = 0;
+	virtual int64_t Read(void *buffer, idx_t nr_bytes) = 0;
+	virtual void Write(void *buffer, idx_t nr_bytes, idx_t location) {
+		throw NotImplementedException("Write not supported for s3redirect:// protocol");
+	}
+	virtual int64_t Write(void *buffer, idx_t nr_bytes) {
+		throw NotImplementedException("Write not supported for s3redirect:// protocol");
+	}
+	virtual void Truncate(int64_t new_size) {
+		throw NotImplementedException("Truncate not supported for s3redirect:// protocol");
+	}
+	virtual void Seek(idx_t location) = 0;
+	virtual idx_t SeekPosition() = 0;
+	virtual idx_t GetFileSize() = 0;
+	virtual timestamp_t GetLastModifiedTime() = 0;
+	virtual FileType GetType() = 0;
+	virtual void Sync() = 0;
+	// True when the bytes live in a local file rather than in S3.
+	virtual bool IsOnDisk() const {
+		return false;
+	}
+};
+
+class S3RedirectFileHandle : public S3RedirectHandle {
 private:
+	// Reads spanning more blocks than this bypass the block cache.
+	static constexpr idx_t MAX_CACHED_BLOCKS_PER_READ = 16;
+
 	string s3_url;
 	idx_t known_content_length;
 	timestamp_t last_modified_time;
@@ -55,22 +102,93 @@ private:
 	// Stored for v1.4.x where pool handles must be opened with an explicit opener.
 	// In v1.5.3+ (OpenerFileSystem) this is unused; the db-level opener is injected automatically.
 	optional_ptr<FileOpener> file_opener;
+	// ETag exported by CWIQ FS; empty when it exports none.
+	string etag;
+	// Hand size, mtime and ETag to httpfs so opening an underlying handle skips its HEAD. Only
+	// possible with a real ETag: httpfs checks it against every response. Unseeded underlying
+	// handles send a HEAD when they are opened, which is never before the first read.
+	bool seed_http_metadata;
 
-	// Primary handle: sequential cursor (Seek / SeekPosition / Read(buf,n)).
-	// Never shared between threads.
+	// Primary handle: sequential cursor (Seek / SeekPosition / Read(buf,n)) when readahead is
+	// disabled. Never shared between threads. Opened lazily on the first sequential read or seek,
+	// so files that are only read positionally never open it at all.
 	unique_ptr<FileHandle> primary_handle;
 
-	// Pool of idle handles for concurrent positional reads.
-	// Each borrow gives one thread exclusive ownership of a handle; the lock is
-	// held only for the O(1) push/pop, never across any network I/O.
-	std::mutex pool_mu;
-	std::vector<unique_ptr<FileHandle>> idle_pool;
+	// DB-wide pool of idle handles for concurrent positional reads, shared with every other
+	// handle on the same object. Each borrow gives one thread exclusive ownership of a handle.
+	S3RedirectHandlePool &handle_pool;
+	// DB-wide cache of aligned blocks for positional reads; block_size is fixed per handle.
+	S3RedirectBlockCache &block_cache;
+	idx_t block_size;
+	// Identity of this object version in the handle pool, block cache and single-flight table:
+	// S3RedirectInfo::ObjectKey, plus the opening client where httpfs handles are opened with that
+	// client's opener (and credentials), so no client is served bytes fetched with another's.
+	string object_key;
+	// Optional on-disk tier behind the block cache, and this object version's key in it (the hash
+	// of object_key).
+	S3RedirectDiskCache &disk_cache;
+	uint64_t disk_cache_object_hash;
+
+	// Sequential cursor when readahead is enabled (readahead_max_window > 0). The primary
+	// handle is then never opened; Read(buf,n) is served by the readahead engine, which is
+	// created on the first sequential read.
+	S3RedirectTaskPool &task_pool;
+	idx_t readahead_initial_window;
+	idx_t readahead_max_window;
+	idx_t sequential_position {0};
+	unique_ptr<S3RedirectReadahead> readahead;
+
+	// Large positional reads are split into parallel ranged GETs (see FetchParallel).
+	idx_t parallel_read_threshold;
+	idx_t parallel_read_part_size;
+	idx_t parallel_read_max_parts;
+	// Merges concurrent small reads of this file into fewer GETs; null when coalescing is off.
+	unique_ptr<S3RedirectReadCoalescer> coalescer;
+	// DB-wide table that lets identical concurrent range GETs share one download.
+	S3RedirectSingleFlight &single_flight;
+	bool single_flight_enabled;
+
+	// DB-wide hedging policy and the latency profile of this object's endpoint. Hedged attempts
+	// run on task_pool and may outlive the read that started them (the loser keeps its handle
+	// until its GET finishes), so the destructor waits for hedge_attempts_in_flight to drain.
+	struct HedgedRead;
+	S3RedirectHedging &hedging;
+	S3RedirectEndpointLatency &endpoint_latency;
+	std::mutex hedge_lock;
+	std::condition_variable hedge_attempts_done;
+	idx_t hedge_attempts_in_flight {0};
 
-	// Opens a fresh underlying httpfs handle with FILE_FLAGS_DIRECT_IO so every
-	// positional read becomes an independent range GET with no shared rolling buffer.
+	// DB-wide admission control every range GET goes through; reads of this handle are queued
+	// under its endpoint and the client context that opened it.
+	S3RedirectIOScheduler &io_scheduler;
+	S3RedirectIOScheduler::Endpoint &io_endpoint;
+	uintptr_t io_client;
+	// DB-wide metrics behind cwiqduck_stats().
+	S3RedirectStats &stats;
+	// This file's entry in the per-query profile of the client that opened it; null when the
+	// handle was opened without a client context. Reads by other clients are charged here too.
+	shared_ptr<S3RedirectFileProfile> query_profile;
+
+	// Local-first routing: ranges the CWIQ FS mount reports as resident are read from the local
+	// file through local_handle (opened only when something is resident); the rest go to S3.
+	shared_ptr<const S3RedirectResidency> residency;
+	unique_ptr<FileHandle> local_handle;
+
+	// Speculative prefetches (parquet footer at open, Prefetch() calls) that positional reads are
+	// served from when they cover the read; null when cwiqduck_prefetch_budget is 0.
+	unique_ptr<S3RedirectPrefetcher> prefetcher;
+	// Small objects (cwiqduck_small_object_threshold): the whole object, fetched in the background
+	// from the moment the handle is created so the downloads of many small files opened by one
+	// scan overlap. Serves every positional and sequential read; null for larger objects, and
+	// reads fall back to the normal path if the fetch failed.
+	unique_ptr<S3RedirectPrefetcher> whole_object;
+
+	// Opens a fresh underlying httpfs handle. With seed_http_metadata the known size, mtime and
+	// ETag are passed as OpenFileInfo options, which httpfs accepts in place of a HEAD. Errors are
+	// IOExceptions worded like a failed OpenFile.
 	unique_ptr<FileHandle> OpenHandle() const;
 
-	// RAII borrow: returns the handle to idle_pool on destruction.
+	// RAII borrow: returns the handle to the shared pool on destruction.
 	struct BorrowedHandle {
 		S3RedirectFileHandle *owner; // pointer (not ref) so the struct is movable
 		unique_ptr<FileHandle> handle;
@@ -97,27 +215,108 @@ private:
 	BorrowedHandle BorrowHandle();
 	void ReturnHandle(unique_ptr<FileHandle> h);
 
+	// Serves [location, location + nr_bytes) from block_cache, fetching each run of missing
+	// blocks with one aligned range GET and publishing the blocks for later readers.
+	void ReadThroughBlockCache(void *buffer, idx_t nr_bytes, idx_t location);
+	// Sequential read behind Read(buf, n), which only adds the metrics around it.
+	int64_t ReadSequential(void *buffer, idx_t nr_bytes);
+	// Positional read of S3 data: through the block cache when small, else ReadRemote.
+	void ReadRedirected(void *buffer, idx_t nr_bytes, idx_t location);
+	// Serves resident ranges from local_handle and the gaps between them from S3, either through
+	// the block cache (positional reads) or straight from ReadRemote (readahead windows).
+	void ReadLocalFirst(void *buffer, idx_t nr_bytes, idx_t location, bool use_block_cache);
+	void PrefetchParquetFooter(idx_t footer_prefetch);
+	// Copies the whole aligned blocks inside a prefetched S3 range into the block cache.
+	void PublishPrefetchedBlocks(const_data_ptr_t data, idx_t nr_bytes, idx_t location);
+	// Everything below the block cache: the disk cache when enabled, otherwise FetchRange.
+	void ReadRemote(void *buffer, idx_t nr_bytes, idx_t location);
+	// Serves whole chunks from disk_cache and fetches each run of missing chunks with one GET.
+	void ReadThroughDiskCache(void *buffer, idx_t nr_bytes, idx_t location);
+	// Network read of an exact range, shared with identical in-flight reads when single-flight
+	// is enabled.
+	void FetchRange(void *buffer, idx_t nr_bytes, idx_t location);
+	// Split into parallel parts when large, otherwise coalesced with concurrent reads of nearby
+	// ranges (or FetchDirect when coalescing is off).
+	void FetchUnshared(void *buffer, idx_t nr_bytes, idx_t location);
+	// Reads at least parallel_read_threshold bytes as part_size-aligned sub-ranges fetched at
+	// the same time on separate pool handles, each written straight into its slice of `buffer`.
+	void FetchParallel(void *buffer, idx_t nr_bytes, idx_t location);
+	// One range GET on a borrowed pool handle under an I/O scheduler slot; returns the GET's
+	// duration in microseconds (excluding the wait for the slot).
+	idx_t ReadPooled(void *buffer, idx_t nr_bytes, idx_t location);
+	// Range GET on a borrowed pool handle, hedged when hedging is enabled and the endpoint has
+	// enough latency samples.
+	void FetchDirect(void *buffer, idx_t nr_bytes, idx_t location);
+	void FetchHedged(void *buffer, idx_t nr_bytes, idx_t location, idx_t deadline_us);
+	// Runs one attempt of a hedged read into its private buffer, unless it already started.
+	void RunHedgeAttempt(HedgedRead &read, idx_t attempt);
+	void ScheduleHedgeAttempt(shared_ptr<HedgedRead> read, idx_t attempt);
+
 public:
-	S3RedirectFileHandle(FileSystem &fs, DatabaseInstance &db, const string &s3_url, idx_t content_length,
-	                     timestamp_t last_modified, optional_ptr<FileOpener> opener);
-	virtual ~S3RedirectFileHandle() {};
+	S3RedirectFileHandle(S3RedirectProtocolFileSystem &fs, DatabaseInstance &db, const string &s3_url,
+	                     idx_t content_length, timestamp_t last_modified, string etag, string object_key,
+	                     optional_ptr<FileOpener> opener, const S3RedirectSettings &settings,
+	                     const string &local_path, shared_ptr<const S3RedirectResidency> residency);
+	~S3RedirectFileHandle() override;
 
 	void Close() override;
 
-	// Positional read: borrows an exclusive handle from the pool.
-	void Read(void *buffer, idx_t nr_bytes, idx_t location);
-	// Sequential read: uses the primary handle.
-	int64_t Read(void *buffer, idx_t nr_bytes);
+	// Positional read: served locally when resident, else from the block cache or a handle
+	// borrowed from the pool.
+	void Read(void *buffer, idx_t nr_bytes, idx_t location) override;
+	// Sequential read: readahead engine, or the primary handle when readahead is disabled.
+	int64_t Read(void *buffer, idx_t nr_bytes) override;
+	// Starts fetching a range (e.g. the column chunks a scan is about to read) in the background;
+	// positional reads inside it are then served from memory. Best effort and non-blocking.
+	void Prefetch(idx_t location, idx_t nr_bytes);
 
 	FileHandle &GetPrimaryHandle();
-	FileType GetType();
-	timestamp_t GetLastModifiedTime();
-	idx_t GetFileSize();
+	void Seek(idx_t location) override;
+	idx_t SeekPosition() override;
+	FileType GetType() override;
+	timestamp_t GetLastModifiedTime() override;
+	idx_t GetFileSize() override;
 	bool CanSeek();
-	void Sync();
-	void Write(void *buffer, idx_t nr_bytes, idx_t location);
-	int64_t Write(void *buffer, idx_t nr_bytes);
-	void Truncate(int64_t new_size);
+	void Sync() override;
+};
+
+// Write-flagged open of a file on a CWIQ FS mount: the local file, with small writes gathered by
+// an S3RedirectWriteBuffer instead of each going to the FUSE daemon on its own. Reads, size
+// queries, truncation and Sync() flush the buffer first, so they see every write and FileSync
+// keeps its durability guarantee. Positional and sequential writes share one cursor, like a
+// local handle.
+class S3RedirectWriteHandle : public S3RedirectHandle {
+public:
+	S3RedirectWriteHandle(S3RedirectProtocolFileSystem &fs, const string &path, FileOpenFlags flags,
+	                      unique_ptr<FileHandle> local_handle, idx_t buffer_size);
+	// Flushes what Close() did not; errors are lost here, so callers close explicitly.
+	~S3RedirectWriteHandle() override;
+
+	void Close() override;
+
+	void Write(void *buffer, idx_t nr_bytes, idx_t location) override;
+	int64_t Write(void *buffer, idx_t nr_bytes) override;
+	void Read(void *buffer, idx_t nr_bytes, idx_t location) override;
+	int64_t Read(void *buffer, idx_t nr_bytes) override;
+	void Seek(idx_t location) override;
+	idx_t SeekPosition() override;
+	idx_t GetFileSize() override;
+	timestamp_t GetLastModifiedTime() override;
+	FileType GetType() override;
+	void Sync() override;
+	void Truncate(int64_t new_size) override;
+	bool IsOnDisk() const override {
+		return true;
+	}
+
+private:
+	LocalFileSystem &local_fs;
+	// Serializes every call: DuckDB may share a handle between threads, and neither the buffer
+	// nor `position` is thread-safe. Held across flushes, so a reader never sees stale data.
+	std::mutex lock;
+	unique_ptr<FileHandle> local_handle;
+	S3RedirectWriteBuffer write_buffer;
+	idx_t position {0};
 };
 
 class S3RedirectProtocolFileSystem : public FileSystem {
@@ -126,9 +325,42 @@ private:
 	// Fallback FS for write-flagged opens. Owned for the DB's lifetime so any
 	// local handle it produces (which keeps a reference back to it) stays valid.
 	LocalFileSystem local_fs;
+	// Shared xattr/stat results for CanHandleFile, FileExists and OpenFile, so one open of a
+	// CWIQ FS file costs a single getxattr round trip instead of up to five.
+	S3RedirectResolutionCache resolution_cache;
+	// Idle httpfs handles shared by the redirect handles of each object, so warm connections
+	// survive Close().
+	// Their estimated memory is reported as pool_idle_bytes in cwiqduck_stats().
+	S3RedirectHandlePool handle_pool;
+	// Aligned blocks of redirected objects, kept hot across queries (parquet footers etc.). Off
+	// unless cwiqduck_block_cache_size is set; not counted against memory_limit.
+	S3RedirectBlockCache block_cache;
+	// Persistent chunk cache on local disk; disabled unless cwiqduck_disk_cache_path is set.
+	S3RedirectDiskCache disk_cache;
+	// In-flight range GETs that concurrent readers of the same range wait on instead of repeating.
+	S3RedirectSingleFlight single_flight;
+	// Which paths are on a CWIQ FS mount, for the buffered write path and globs.
+	S3RedirectMountTable mount_table;
+	// Percentile-deadline hedging of range GETs; off unless cwiqduck_hedged_reads is set.
+	S3RedirectHedging hedging;
+	// Global / per-endpoint in-flight caps with fair queuing and AIMD backoff on throttling.
+	S3RedirectIOScheduler io_scheduler;
+	// Operation latencies and counter baselines for cwiqduck_stats().
+	S3RedirectStats stats;
+	// httpfs is loaded by the first redirected open rather than when this extension loads.
+	std::mutex httpfs_load_lock;
+	std::atomic<bool> httpfs_loaded {false};
+	// S3RedirectSettings::GetPathSettingsGeneration() the path settings were last applied at.
+	std::mutex path_settings_lock;
+	std::atomic<idx_t> path_settings_generation {DConstants::INVALID_INDEX};
+	// cwiqduck_write_buffer_size as of the last refresh.
+	std::atomic<idx_t> write_buffer_size {0};
+	// Background I/O threads (readahead). Declared last so it is joined before anything its
+	// tasks might touch is destroyed.
+	S3RedirectTaskPool task_pool;
 
 public:
-	S3RedirectProtocolFileSystem(DatabaseInstance &db) : db_instance(db) {};
+	S3RedirectProtocolFileSystem(DatabaseInstance &db);
 
 	unique_ptr<FileHandle> OpenFile(const string &path, FileOpenFlags flags,
 	                                optional_ptr<FileOpener> opener = nullptr) override;
@@ -143,9 +375,7 @@ public:
 	bool CanSeek() override {
 		return true;
 	};
-	bool OnDiskFile(FileHandle &handle) override {
-		return false;
-	};
+	bool OnDiskFile(FileHandle &handle) override;
 	void Seek(FileHandle &handle, idx_t location) override;
 	idx_t SeekPosition(FileHandle &handle) override;
 	int64_t GetFileSize(FileHandle &handle) override;
@@ -159,31 +389,83 @@ public:
 		return NotImplementedException(where + "not supported for s3redirect:// protocol");
 	};
 
-	void Write(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) override {
-		throw NotImplemented(__func__);
-	};
+	// Only write-buffered handles are writable (see S3RedirectHandle).
+	void Write(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) override;
+	int64_t Write(FileHandle &handle, void *buffer, int64_t nr_bytes) override;
+	void Truncate(FileHandle &handle, int64_t new_size) override;
+
+	// Directory and file management is the mount's business: with write buffering on,
+	// CanHandleFile claims every path on a CWIQ FS mount, so these go to the local filesystem.
 	void CreateDirectory(const string &directory, optional_ptr<FileOpener> opener = nullptr) override {
-		throw NotImplemented(__func__);
+		local_fs.CreateDirectory(directory, opener);
 	};
 	bool DirectoryExists(const string &directory, optional_ptr<FileOpener> opener = nullptr) override {
-		throw NotImplemented(__func__);
+		return local_fs.DirectoryExists(directory, opener);
 	};
 	void RemoveDirectory(const string &directory, optional_ptr<FileOpener> opener = nullptr) override {
-		throw NotImplemented(__func__);
+		local_fs.RemoveDirectory(directory, opener);
 	};
 	void RemoveFile(const string &filename, optional_ptr<FileOpener> opener = nullptr) override {
-		throw NotImplemented(__func__);
+		local_fs.RemoveFile(filename, opener);
+	};
+	bool TryRemoveFile(const string &filename, optional_ptr<FileOpener> opener = nullptr) override {
+		return local_fs.TryRemoveFile(filename, opener);
 	};
 	void MoveFile(const string &source, const string &target, optional_ptr<FileOpener> opener = nullptr) override {
-		throw NotImplemented(__func__);
+		local_fs.MoveFile(source, target, opener);
 	};
 	bool ListFiles(const string &directory, const std::function<void(const string &, bool)> &callback,
 	               FileOpener *opener = nullptr) override {
-		throw NotImplemented(__func__);
-	};
-	void Truncate(FileHandle &handle, int64_t new_size) override {
-		throw NotImplemented(__func__);
+		return local_fs.ListFiles(directory, callback, opener);
 	};
+
+	// Cached equivalent of ConvertLocalPathToS3; throws the same IOException on failure.
+	S3RedirectInfo ResolvePath(const string &local_path, bool probe_residency = false);
+	// Loads httpfs on first use; throws an IOException when it cannot be loaded.
+	void EnsureHttpfsLoaded();
+	// Applies the path settings (resolver, write buffering, mounts) when one changed since the
+	// last call; otherwise a single atomic load.
+	void RefreshPathSettings();
+	// Cached resolution, timed for cwiqduck_stats().
+	S3RedirectResolution Resolve(const string &local_path, bool probe_residency = false, bool probe_etag = false);
+	// True when writes to `path` get a buffered handle: write buffering is on and the path is on
+	// a CWIQ FS mount. Cheap when buffering is off or the path has a URL scheme.
+	bool IsBufferedWritePath(const string &path);
+	S3RedirectStats::counter_list_t CollectCounters();
+	S3RedirectResolutionCache &GetResolutionCache() {
+		return resolution_cache;
+	}
+	S3RedirectHandlePool &GetHandlePool() {
+		return handle_pool;
+	}
+	S3RedirectBlockCache &GetBlockCache() {
+		return block_cache;
+	}
+	S3RedirectDiskCache &GetDiskCache() {
+		return disk_cache;
+	}
+	LocalFileSystem &GetLocalFileSystem() {
+		return local_fs;
+	}
+	S3RedirectSingleFlight &GetSingleFlight() {
+		return single_flight;
+	}
+	S3RedirectHedging &GetHedging() {
+		return hedging;
+	}
+	S3RedirectStats &GetStats() {
+		return stats;
+	}
+	// Rows of cwiqduck_stats(): operation latencies, component counters since the last reset and
+	// current gauges.
+	vector<S3RedirectStatRow> SnapshotStats();
+	void ResetStats();
+	S3RedirectIOScheduler &GetIOScheduler() {
+		return io_scheduler;
+	}
+	S3RedirectTaskPool &GetTaskPool() {
+		return task_pool;
+	}
 };
 
 S3RedirectInfo ConvertLocalPathToS3(const string &local_path);
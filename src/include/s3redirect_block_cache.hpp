@@ -0,0 +1,92 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+// One cached, block-aligned slice of a redirected object. Immutable once published, so readers
+// copy out of it without holding any cache lock.
+struct S3RedirectBlock {
+	S3RedirectBlock(unsafe_unique_array<data_t> data_p, idx_t size_p) : data(std::move(data_p)), size(size_p) {
+	}
+	unsafe_unique_array<data_t> data;
+	idx_t size;
+};
+
+// Database-wide in-memory cache of aligned blocks of redirected objects, consulted by
+// S3RedirectFileHandle positional reads. Keys are (object, block size, block index) where the
+// object key identifies the object version (S3RedirectFileHandle::object_key), so a rewritten
+// object never serves stale bytes and changing the block size never aliases blocks of a different
+// size. Blocks live on the heap, outside DuckDB's buffer manager and memory_limit; GetSizeBytes()
+// is reported by cwiqduck_stats().
+//
+// The byte budget is split over independently locked LRU shards so parallel scan threads do not
+// serialize on one mutex; a lock is only held for the map/list update, never for a copy or a GET.
+class S3RedirectBlockCache {
+public:
+	static constexpr idx_t SHARD_COUNT = 32;
+
+	void SetCapacity(idx_t capacity_bytes);
+	bool Enabled() const {
+		return capacity.load(std::memory_order_relaxed) > 0;
+	}
+
+	shared_ptr<const S3RedirectBlock> Get(const string &object_key, idx_t block_size, idx_t block_index);
+	void Put(const string &object_key, idx_t block_size, idx_t block_index, shared_ptr<const S3RedirectBlock> block);
+	void Clear();
+
+	idx_t GetHits() const {
+		return hits.load(std::memory_order_relaxed);
+	}
+	idx_t GetMisses() const {
+		return misses.load(std::memory_order_relaxed);
+	}
+	idx_t GetEvictions() const {
+		return evictions.load(std::memory_order_relaxed);
+	}
+	idx_t GetSizeBytes() const {
+		return size_bytes.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct BlockKey {
+		string object_key;
+		idx_t block_size;
+		idx_t block_index;
+
+		bool operator==(const BlockKey &other) const {
+			return block_index == other.block_index && block_size == other.block_size &&
+			       object_key == other.object_key;
+		}
+	};
+	struct BlockKeyHash {
+		size_t operator()(const BlockKey &key) const;
+	};
+	struct Entry {
+		shared_ptr<const S3RedirectBlock> block;
+		std::list<BlockKey>::iterator lru_position;
+	};
+	struct Shard {
+		std::mutex lock;
+		// Front = most recently used.
+		std::list<BlockKey> lru;
+		std::unordered_map<BlockKey, Entry, BlockKeyHash> entries;
+		idx_t size_bytes {0};
+	};
+
+	Shard &GetShard(const BlockKey &key);
+
+	Shard shards[SHARD_COUNT];
+	std::atomic<idx_t> capacity {0};
+	std::atomic<idx_t> size_bytes {0};
+	std::atomic<idx_t> hits {0};
+	std::atomic<idx_t> misses {0};
+	std::atomic<idx_t> evictions {0};
+};
+
+} // namespace duckdb
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace duckdb {
+
+// Optional second cache tier on local disk (NVMe), shared by every redirect handle of the
+// database and persistent across process restarts.
+//
+// Objects are stored as fixed-size chunks, one file per chunk, under the cache directory. A chunk
+// is identified by a 64-bit hash of the object key (S3RedirectInfo::ObjectKey) plus its index, so
+// a new version of an object simply addresses different chunks and the stale ones age out. The
+// compact binary index (40 bytes per chunk) records chunk sizes, checksums and LRU order; it is
+// rewritten atomically and fsync()ed every INDEX_FLUSH_INTERVAL inserts and on shutdown. Chunk files
+// are published with write-to-temp + rename but not fsync()ed, so after a crash a chunk may be
+// short or hold garbage; every hit checks the file length and checksum against the index and
+// drops a chunk that does not match.
+//
+// Processes may share a directory. Temp files carry the writer's pid, so concurrent writers never
+// collide. Orphan cleanup leaves files younger than ORPHAN_MIN_AGE alone, since they may be
+// another process's writes in progress or its chunks not yet in the index. Index flushes
+// read-merge-write the index under an flock(), so one process's flush keeps the other's entries.
+// A process only sees the other's chunks from the index it loads when the directory is
+// configured, and the size cap is enforced by each process over the chunks it knows about.
+class S3RedirectDiskCache {
+public:
+	static constexpr idx_t CHUNK_SIZE = idx_t(1) << 20;
+	static constexpr idx_t INDEX_FLUSH_INTERVAL = 256;
+	static constexpr int64_t ORPHAN_MIN_AGE_SECONDS = 3600;
+
+	~S3RedirectDiskCache();
+
+	// (Re)targets the cache. An empty directory or a zero capacity disables it. Switching to a
+	// new directory persists the old index and loads the one found in the new directory, creating
+	// the directory (and its parents) first. Returns why the directory cannot be used the first
+	// time it fails, empty otherwise; the cache stays disabled until the setting changes.
+	string Configure(const string &directory, idx_t capacity_bytes);
+	bool Enabled() const {
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	static uint64_t ObjectHash(const string &object_key);
+
+	// Reads a whole chunk (exactly `size` bytes) into `target`. Returns false on a miss.
+	bool ReadChunk(uint64_t object_hash, idx_t chunk_index, data_ptr_t target, idx_t size);
+	void WriteChunk(uint64_t object_hash, idx_t chunk_index, const_data_ptr_t data, idx_t size);
+	// Persists the index for the next process.
+	void Flush();
+
+	idx_t GetHits() const {
+		return hits.load(std::memory_order_relaxed);
+	}
+	idx_t GetMisses() const {
+		return misses.load(std::memory_order_relaxed);
+	}
+	idx_t GetSizeBytes() const {
+		return size_bytes.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct ChunkKey {
+		uint64_t object_hash;
+		uint64_t chunk_index;
+
+		bool operator==(const ChunkKey &other) const {
+			return object_hash == other.object_hash && chunk_index == other.chunk_index;
+		}
+	};
+	struct ChunkKeyHash {
+		size_t operator()(const ChunkKey &key) const {
+			return std::hash<uint64_t>()(key.object_hash ^ (key.chunk_index * 0x9e3779b97f4a7c15ULL));
+		}
+	};
+	struct Entry {
+		uint32_t size;
+		uint64_t checksum;
+		uint64_t last_access;
+		std::list<ChunkKey>::iterator lru_position;
+	};
+
+	static uint64_t ChunkChecksum(const_data_ptr_t data, idx_t size);
+	string ChunkPath(const string &dir, const ChunkKey &key) const;
+	string IndexPath(const string &dir) const;
+	// Both expect `lock` to be held.
+	void LoadIndexLocked();
+	void InsertLocked(const ChunkKey &key, uint32_t size, uint64_t checksum, uint64_t last_access);
+	void RemoveLocked(const ChunkKey &key, vector<string> &unlink_paths);
+	// Removes chunk files (and temp files) that the index does not know about and that are older
+	// than ORPHAN_MIN_AGE_SECONDS.
+	void RemoveOrphansLocked();
+	// Unique per process and per call, so concurrent writers never share a temp file.
+	string TempPath(const string &path);
+
+	std::mutex lock;
+	// Serializes index writers; never held together with `lock`.
+	std::mutex flush_lock;
+	string directory;
+	idx_t capacity {0};
+	// Front = most recently used.
+	std::list<ChunkKey> lru;
+	std::unordered_map<ChunkKey, Entry, ChunkKeyHash> entries;
+	uint64_t access_clock {0};
+	idx_t inserts_since_flush {0};
+	// Chunks this process evicted since the last flush, which merging the index on disk (written
+	// by other processes) must not bring back.
+	std::unordered_set<ChunkKey, ChunkKeyHash> evicted_since_flush;
+	// Directory whose creation failed; not retried (or reported again) until the setting changes.
+	string failed_directory;
+
+	std::atomic<bool> enabled {false};
+	std::atomic<idx_t> size_bytes {0};
+	std::atomic<idx_t> hits {0};
+	std::atomic<idx_t> misses {0};
+	std::atomic<idx_t> temp_file_counter {0};
+};
+
+} // namespace duckdb
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Database-wide pool of idle httpfs handles, owned by S3RedirectProtocolFileSystem so warm
+// connections outlive any single S3RedirectFileHandle: repeated queries and reopens of the same
+// object start warm. Different objects never share a handle.
+//
+// Handles are bound to one object in httpfs, so the key is the object identity (see
+// S3RedirectFileHandle::object_key: a rewritten object never gets a handle that cached its old
+// size, and handles carrying one client's opener never serve another). The pool is bounded per
+// key and globally; when either cap is hit the least recently returned handle is closed. Handles
+// idle longer than the timeout are reaped whenever the pool is touched, and by a background
+// reaper thread while the pool holds any, so a pool nobody uses any more still drains. The reaper
+// also shrinks the pool back to `target_idle` handles after a burst: handles beyond the target
+// are closed once they have been idle for one reap interval.
+// The lock only guards O(1) list/map operations; handles are closed outside of it.
+//
+// In front of the shared LRU, every thread has a one-handle slot of its own: Release parks the
+// handle there and the same thread's next Acquire of the same object takes it back with one
+// uncontended atomic exchange and no lock, which is the common case for a scan thread reading
+// one file. Only a handle displaced from a slot, or an Acquire of a different object, goes
+// through the lock. Slots sit outside the caps (there is one per thread); the reaper closes
+// expired slot handles and drops the slots of threads that are gone.
+//
+// GetIdleBytes() reports the idle handles at HANDLE_MEMORY_ESTIMATE each: every handle in the
+// shared LRU and every handle parked in a slot. Parking into an empty slot and taking a handle
+// back out adjust the count with one atomic add, without the pool lock; an empty slot counts for
+// nothing. The figure is a guess at httpfs's footprint, not a measurement, so
+// it is only reported (cwiqduck_stats' pool_idle_bytes) and never charged against memory_limit.
+class S3RedirectHandlePool {
+public:
+	static constexpr idx_t DEFAULT_MAX_PER_KEY = 16;
+	static constexpr idx_t DEFAULT_MAX_TOTAL = 256;
+	static constexpr idx_t DEFAULT_TARGET_IDLE = 32;
+	static constexpr idx_t DEFAULT_IDLE_TIMEOUT_MS = 30000;
+	// Rough footprint of one idle httpfs handle: its read buffer plus the connection and TLS state.
+	static constexpr idx_t HANDLE_MEMORY_ESTIMATE = idx_t(1) << 20;
+
+	S3RedirectHandlePool();
+	// Stops the reaper and closes every idle handle.
+	~S3RedirectHandlePool();
+
+	void SetLimits(idx_t max_per_key, idx_t max_total, idx_t target_idle, idx_t idle_timeout_ms);
+
+	// Returns the most recently returned idle handle for `key`, or nullptr on a miss.
+	unique_ptr<FileHandle> Acquire(const string &key);
+	// Hands an idle handle back; it may be closed right away if the pool is full.
+	void Release(const string &key, unique_ptr<FileHandle> handle);
+	// Closes handles that have been idle longer than the timeout. Returns how many were closed.
+	idx_t ReapIdle();
+	// Closes every idle handle.
+	void Clear();
+
+	idx_t GetIdleCount();
+	// Estimated bytes held by idle handles (see the class comment).
+	idx_t GetIdleBytes() const {
+		return idx_t(MaxValue<int64_t>(idle_handles.load(std::memory_order_relaxed), 0)) * HANDLE_MEMORY_ESTIMATE;
+	}
+	// Handles closed for being idle too long or above the target, by the reaper or on access.
+	idx_t GetReaped() const {
+		return reaped.load(std::memory_order_relaxed);
+	}
+	// Hits of the shared LRU plus the thread slots.
+	idx_t GetHits();
+	idx_t GetMisses() const {
+		return misses.load(std::memory_order_relaxed);
+	}
+
+private:
+	using pool_clock_t = std::chrono::steady_clock;
+
+	struct IdleHandle {
+		string key;
+		unique_ptr<FileHandle> handle;
+		pool_clock_t::time_point idle_since;
+	};
+	using lru_iterator = std::list<IdleHandle>::iterator;
+
+	// A thread's private parking spot. Only the owning thread stores into `idle`; the reaper and
+	// Clear() take handles out with an exchange too, so neither side ever blocks the other.
+	struct alignas(64) ThreadSlot {
+		std::atomic<IdleHandle *> idle {nullptr};
+		// Written by the owning thread only.
+		std::atomic<idx_t> hits {0};
+
+		~ThreadSlot() {
+			delete idle.load(std::memory_order_relaxed);
+		}
+	};
+
+	// One entry per thread: a thread switching between databases re-registers, and the slot it
+	// left behind is dropped by that pool's reaper.
+	struct ThreadSlotCache {
+		uint64_t pool_id {0};
+		shared_ptr<ThreadSlot> slot;
+	};
+	static thread_local ThreadSlotCache thread_slot_cache;
+
+	// This thread's slot in this pool, registered on first use.
+	ThreadSlot &GetThreadSlot();
+	// Adds a handle to the shared LRU, closing whatever the caps push out.
+	void InsertLocked(IdleHandle idle, vector<unique_ptr<FileHandle>> &closed);
+	// Moves a handle displaced from a thread slot into the shared LRU.
+	void ReleaseShared(unique_ptr<IdleHandle> idle);
+	// Reaper pass over the slots: closes expired handles and drops slots of exited threads.
+	// `emptied_slots` counts the slots whose handle was closed or moved to the shared LRU.
+	void ReapSlotsLocked(pool_clock_t::time_point now, vector<unique_ptr<FileHandle>> &closed,
+	                     idx_t &emptied_slots);
+
+	// Unlinks `position` from both indexes and hands its FileHandle to `closed`.
+	void RemoveLocked(lru_iterator position, vector<unique_ptr<FileHandle>> &closed);
+	void ReapLocked(pool_clock_t::time_point now, vector<unique_ptr<FileHandle>> &closed);
+	// Between clamp(idle_timeout / 4, 100ms, 5s) reaper passes.
+	pool_clock_t::duration ReapIntervalLocked() const;
+	void ReaperLoop();
+	// Adjusts the idle handle count behind GetIdleBytes().
+	void ReportIdleChange(int64_t idle_delta);
+	static void CloseAll(vector<unique_ptr<FileHandle>> &closed);
+
+	std::mutex lock;
+	// Front = most recently returned; the back is the eviction candidate.
+	std::list<IdleHandle> lru;
+	// Per key, oldest first, so back() is the warmest handle for that object.
+	std::unordered_map<string, vector<lru_iterator>> by_key;
+
+	idx_t max_per_key {DEFAULT_MAX_PER_KEY};
+	idx_t max_total {DEFAULT_MAX_TOTAL};
+	idx_t target_idle {DEFAULT_TARGET_IDLE};
+	std::chrono::milliseconds idle_timeout {DEFAULT_IDLE_TIMEOUT_MS};
+
+	std::atomic<int64_t> idle_handles {0};
+
+	// Distinguishes this pool in thread-local slot caches, which outlive it.
+	const uint64_t pool_id;
+	// Registered slots; the calling thread's cache holds the other reference.
+	vector<shared_ptr<ThreadSlot>> thread_slots;
+	// Read without the lock by Release, which parks handles only while pooling is enabled.
+	std::atomic<bool> pooling_enabled {true};
+
+	// Started with the first pooled handle; sleeps without a timeout while the pool is empty.
+	std::thread reaper;
+	std::condition_variable reaper_wakeup;
+	bool shutdown {false};
+
+	std::atomic<idx_t> hits {0};
+	std::atomic<idx_t> misses {0};
+	std::atomic<idx_t> reaped {0};
+};
+
+} // namespace duckdb
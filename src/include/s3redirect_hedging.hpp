@@ -0,0 +1,88 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Recent range GET latencies and hedge budget of one endpoint (scheme + bucket). Latencies go
+// into log-linear buckets (four per power of two of microseconds, so a percentile is accurate to
+// about 20%); once DECAY_SAMPLES have been recorded every bucket is halved, so the distribution
+// follows the endpoint as its latency drifts.
+class S3RedirectEndpointLatency {
+public:
+	static constexpr idx_t BUCKET_COUNT = 160;
+	static constexpr idx_t MIN_SAMPLES = 50;
+	static constexpr idx_t DECAY_SAMPLES = 4096;
+
+	void Record(idx_t micros);
+	// Upper bound in microseconds of the given percentile, or 0 while there are too few samples.
+	idx_t Percentile(idx_t percentile) const;
+
+	// Counts one read towards the hedge budget.
+	void CountRequest() {
+		requests.fetch_add(1, std::memory_order_relaxed);
+	}
+	// Claims a hedge if that keeps hedges within max_ratio_percent of all reads (plus one, so an
+	// endpoint's first stragglers can be hedged).
+	bool TryStartHedge(idx_t max_ratio_percent);
+
+private:
+	static idx_t BucketIndex(idx_t micros);
+	static idx_t BucketUpperBound(idx_t index);
+
+	mutable std::mutex lock;
+	idx_t buckets[BUCKET_COUNT] = {};
+	idx_t samples {0};
+	idx_t since_decay {0};
+
+	std::atomic<idx_t> requests {0};
+	std::atomic<idx_t> hedges {0};
+};
+
+// Database-wide hedging policy for positional range GETs. When enabled, a read that has not
+// completed within its endpoint's latency percentile (but never sooner than min_delay) gets a
+// duplicate GET on another pooled handle and the first to finish wins. Hedges are rate-limited
+// per endpoint to max_ratio_percent of reads, so a slow endpoint is not hit with double traffic.
+class S3RedirectHedging {
+public:
+	void Configure(bool enabled, idx_t percentile, idx_t max_ratio_percent, idx_t min_delay_ms);
+	bool Enabled() const {
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	// Latency state of the endpoint serving `s3_url`; the reference stays valid for the lifetime
+	// of this object, so handles look it up once at open.
+	S3RedirectEndpointLatency &GetEndpoint(const string &s3_url);
+
+	// Hedge deadline in microseconds for the endpoint, or 0 when it has too few samples to hedge.
+	idx_t GetDeadline(const S3RedirectEndpointLatency &endpoint) const;
+	bool TryStartHedge(S3RedirectEndpointLatency &endpoint);
+
+	void RecordHedgeWin() {
+		hedges_won.fetch_add(1, std::memory_order_relaxed);
+	}
+	idx_t GetHedgesSent() const {
+		return hedges_sent.load(std::memory_order_relaxed);
+	}
+	idx_t GetHedgesWon() const {
+		return hedges_won.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<bool> enabled {false};
+	std::atomic<idx_t> percentile {95};
+	std::atomic<idx_t> max_ratio_percent {5};
+	std::atomic<idx_t> min_delay_us {5000};
+
+	std::mutex endpoints_lock;
+	std::unordered_map<string, unique_ptr<S3RedirectEndpointLatency>> endpoints;
+
+	std::atomic<idx_t> hedges_sent {0};
+	std::atomic<idx_t> hedges_won {0};
+};
+
+} // namespace duckdb
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Database-wide admission control for range GETs of redirected objects. Every network read takes
+// a slot for the duration of its GET; a slot is only granted while the global in-flight count is
+// below its cap and the endpoint's (scheme + bucket) count is below that endpoint's current
+// limit.
+//
+// Waiting reads are queued per client (the ClientContext that opened the file) and served round
+// robin, so one heavy scan cannot starve an interactive query on the same database: each client
+// with waiting reads gets the next free slot in turn, regardless of how many reads it queued.
+//
+// Endpoint limits follow AIMD: a throttling response (503 SlowDown, 429) halves the limit, at
+// most once per THROTTLE_COOLDOWN so one burst of rejections counts once, and every successful
+// GET adds 1/limit, regaining one slot per limit's worth of successes up to the configured cap.
+class S3RedirectIOScheduler {
+public:
+	static constexpr std::chrono::milliseconds THROTTLE_COOLDOWN {1000};
+
+	class Endpoint {
+	public:
+		// Current AIMD limit; 0 until the endpoint is first throttled (it then runs at the cap).
+		idx_t GetLimit() const {
+			return idx_t(limit.load(std::memory_order_relaxed));
+		}
+
+	private:
+		friend class S3RedirectIOScheduler;
+		// Guarded by the scheduler lock.
+		idx_t in_flight {0};
+		std::chrono::steady_clock::time_point last_decrease;
+		// Fractional AIMD limit, 0 = at the cap; written under the scheduler lock.
+		std::atomic<double> limit {0};
+	};
+
+	// Holds one in-flight slot; releases it (reporting the outcome) on destruction.
+	class Slot {
+	public:
+		Slot() : scheduler(nullptr), endpoint(nullptr) {
+		}
+		Slot(S3RedirectIOScheduler &scheduler_p, Endpoint &endpoint_p)
+		    : scheduler(&scheduler_p), endpoint(&endpoint_p) {
+		}
+		Slot(Slot &&other) noexcept
+		    : scheduler(other.scheduler), endpoint(other.endpoint), throttled(other.throttled) {
+			other.scheduler = nullptr;
+		}
+		Slot(const Slot &) = delete;
+		Slot &operator=(const Slot &) = delete;
+		~Slot() {
+			if (scheduler) {
+				scheduler->Release(*endpoint, throttled);
+			}
+		}
+		// Marks the GET as rejected by throttling; the endpoint backs off on release.
+		void SetThrottled() {
+			throttled = true;
+		}
+
+	private:
+		S3RedirectIOScheduler *scheduler;
+		Endpoint *endpoint;
+		bool throttled {false};
+	};
+
+	// Caps of 0 disable admission control; Acquire then returns an empty slot immediately.
+	void Configure(idx_t max_in_flight, idx_t max_in_flight_per_endpoint);
+	bool Enabled() const {
+		return max_in_flight.load(std::memory_order_relaxed) > 0;
+	}
+
+	// Endpoint of `s3_url`; the reference stays valid for the lifetime of the scheduler.
+	Endpoint &GetEndpoint(const string &s3_url);
+	// Blocks until `client` may start a GET against `endpoint`.
+	Slot Acquire(Endpoint &endpoint, uintptr_t client);
+
+	// True when an exception message from httpfs reports a throttling response: HTTP status 429 or
+	// 503, or S3's SlowDown error code.
+	static bool IsThrottlingError(const string &message);
+
+	idx_t GetQueueDepth() const {
+		return queue_depth.load(std::memory_order_relaxed);
+	}
+	idx_t GetInFlight() const {
+		return global_in_flight_metric.load(std::memory_order_relaxed);
+	}
+	idx_t GetQueuedRequests() const {
+		return queued_requests.load(std::memory_order_relaxed);
+	}
+	idx_t GetWaitMicros() const {
+		return wait_micros.load(std::memory_order_relaxed);
+	}
+	idx_t GetThrottleEvents() const {
+		return throttle_events.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Waiter {
+		Endpoint *endpoint;
+		std::condition_variable granted_signal;
+		bool granted {false};
+		// False when released by Configure disabling the scheduler rather than given a slot.
+		bool slot_taken {false};
+	};
+
+	void Release(Endpoint &endpoint, bool throttled);
+	// Expects `lock` to be held.
+	double EffectiveLimitLocked(const Endpoint &endpoint) const;
+	bool HasCapacityLocked(const Endpoint &endpoint) const;
+	void GrantLocked(Endpoint &endpoint);
+	void DispatchLocked();
+
+	std::atomic<idx_t> max_in_flight {0};
+	std::atomic<idx_t> max_in_flight_per_endpoint {0};
+
+	mutable std::mutex lock;
+	idx_t global_in_flight {0};
+	std::unordered_map<string, unique_ptr<Endpoint>> endpoints;
+	// Waiters per client, and the round-robin order of clients that have any.
+	std::unordered_map<uintptr_t, std::deque<Waiter *>> queues;
+	std::deque<uintptr_t> client_order;
+
+	std::atomic<idx_t> queue_depth {0};
+	std::atomic<idx_t> global_in_flight_metric {0};
+	std::atomic<idx_t> queued_requests {0};
+	std::atomic<idx_t> wait_micros {0};
+	std::atomic<idx_t> throttle_events {0};
+};
+
+} // namespace duckdb
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace duckdb {
+
+// Tells whether a path lives on a CWIQ FS mount: a mount in /proc/self/mounts whose filesystem
+// type is the configured one (FUSE reports "fuse.cwiqfs"), or one of the directories configured
+// explicitly. The table and the working directory are read into an immutable snapshot at most
+// once per RELOAD_INTERVAL_US, and each thread keeps its own reference to the current snapshot,
+// so a lookup is a longest-prefix match with no syscall and no lock. Relative paths are made
+// absolute against the working directory of the snapshot; symlinks are not resolved.
+class S3RedirectMountTable {
+public:
+	static constexpr int64_t RELOAD_INTERVAL_US = 5000000;
+	static constexpr const char *DEFAULT_FILESYSTEM_TYPE = "fuse.cwiqfs";
+
+	S3RedirectMountTable();
+
+	// Mounts of type `filesystem_type` (none when empty) count, and so does every directory in
+	// `extra_paths`. A change takes effect on the next lookup.
+	void Configure(const string &filesystem_type, const vector<string> &extra_paths);
+	bool IsCwiqfsPath(const string &path);
+
+private:
+	struct Mount {
+		string mount_point;
+		bool cwiqfs;
+	};
+
+	struct Snapshot {
+		// Sorted longest mount point first; only the extra paths when the table cannot be read.
+		vector<Mount> mounts;
+		string cwd;
+	};
+
+	// One entry per thread, like the handle pool's slot cache.
+	struct SnapshotCache {
+		uint64_t table_id {0};
+		idx_t generation {0};
+		shared_ptr<const Snapshot> snapshot;
+	};
+	static thread_local SnapshotCache snapshot_cache;
+
+	static shared_ptr<const Snapshot> Load(const string &filesystem_type, const vector<string> &extra_paths);
+	const Snapshot &GetSnapshot();
+
+	// Distinguishes this table in thread-local caches, which outlive it.
+	const uint64_t table_id;
+	std::mutex lock;
+	string filesystem_type;
+	vector<string> extra_paths;
+	shared_ptr<const Snapshot> snapshot;
+	// Bumped whenever `snapshot` is replaced.
+	std::atomic<idx_t> generation {0};
+	// Steady-clock time (us) of the next read of the mount table; 0 forces one.
+	std::atomic<int64_t> next_load_us {0};
+};
+
+} // namespace duckdb
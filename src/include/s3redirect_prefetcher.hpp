@@ -0,0 +1,66 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "s3redirect_task_pool.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace duckdb {
+
+// Speculative range prefetches for one S3RedirectFileHandle, e.g. the parquet footer fetched
+// while DuckDB is still opening the file.
+//
+// Prefetch() starts a fetch on the task pool and returns immediately. A later positional read
+// that lies entirely inside a prefetched range is served from it, waiting for the fetch when it
+// is still in flight (or running it on the reader's thread when no worker has picked it up).
+// Prefetches are best effort: a failed one is dropped and the read takes the normal path. Ranges
+// are kept until the handle closes, up to `budget` bytes; prefetches beyond the budget are
+// ignored. Unlike the readahead engine, instances are shared by the handle's reader threads.
+class S3RedirectPrefetcher {
+public:
+	// Reads `nr_bytes` at `location` into `buffer`; throws on failure.
+	using fetch_function_t = std::function<void(data_ptr_t buffer, idx_t nr_bytes, idx_t location)>;
+
+	S3RedirectPrefetcher(S3RedirectTaskPool &task_pool, fetch_function_t fetch, idx_t budget);
+	// Cancels queued prefetches and waits for the ones already running.
+	~S3RedirectPrefetcher();
+
+	void Prefetch(idx_t offset, idx_t length);
+	// Copies [location, location + nr_bytes) out of a prefetched range that covers it. Returns
+	// false when no successful prefetch covers the whole read.
+	bool TryRead(data_ptr_t buffer, idx_t nr_bytes, idx_t location);
+
+private:
+	enum class RangeState { PENDING, RUNNING, DONE, CANCELLED };
+
+	struct Range {
+		idx_t offset;
+		idx_t length;
+		unsafe_unique_array<data_t> data;
+		std::mutex lock;
+		std::condition_variable done;
+		RangeState state {RangeState::PENDING};
+		std::exception_ptr error;
+	};
+
+	// Runs `range` if it is still pending; used by pool workers and by readers.
+	void RunRange(Range &range);
+
+	S3RedirectTaskPool &task_pool;
+	fetch_function_t fetch;
+	idx_t budget;
+
+	std::mutex lock;
+	vector<shared_ptr<Range>> ranges;
+	idx_t reserved_bytes {0};
+
+	// Prefetches handed to the pool that have not finished yet; the destructor waits for zero.
+	std::mutex in_flight_lock;
+	std::condition_variable in_flight_done;
+	idx_t in_flight {0};
+};
+
+} // namespace duckdb
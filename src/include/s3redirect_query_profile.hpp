@@ -0,0 +1,90 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/main/client_context_state.hpp"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace duckdb {
+
+// I/O of one redirected file during the current query of one client. Redirect handles hold their
+// entry for their whole life and bump it from whichever thread does the work (including readahead,
+// prefetch and hedge tasks), so every field is a relaxed atomic.
+struct S3RedirectFileProfile {
+	// Positional and sequential reads issued by DuckDB, and the bytes they returned.
+	std::atomic<idx_t> reads {0};
+	std::atomic<idx_t> bytes_read {0};
+	// Range GETs sent for this file, their bytes and the time spent in them.
+	std::atomic<idx_t> requests {0};
+	std::atomic<idx_t> request_bytes {0};
+	std::atomic<idx_t> request_micros {0};
+	// Time spent queued for an I/O scheduler slot before those GETs.
+	std::atomic<idx_t> queue_wait_micros {0};
+	// Cache lookups answered from a cache, and those that had to be fetched. A lookup is counted at
+	// the granularity of the cache that answered it: one per read served whole from the object or
+	// prefetch cache, one per disk-cache chunk, one per block-cache block. The counts therefore mix
+	// units; compare them within one configuration, not across cache settings.
+	std::atomic<idx_t> cache_hits {0};
+	std::atomic<idx_t> cache_misses {0};
+	// Bytes served from the CWIQ FS mount instead of S3.
+	std::atomic<idx_t> local_bytes {0};
+
+	void Reset();
+};
+
+// Plain copy of an S3RedirectFileProfile, as reported by cwiqduck_query_profile().
+struct S3RedirectFileProfileRow {
+	string path;
+	idx_t reads;
+	idx_t bytes_read;
+	idx_t requests;
+	idx_t request_bytes;
+	idx_t request_micros;
+	idx_t queue_wait_micros;
+	idx_t cache_hits;
+	idx_t cache_misses;
+	idx_t local_bytes;
+
+	// NaN when the file was never looked up in a cache.
+	double CacheHitRatio() const;
+};
+
+// Per-client I/O profile of the redirect filesystem, kept in the ClientContext's registered state.
+// Counters restart at every query; the finished query's rows are kept until the next one ends, so
+// cwiqduck_query_profile() (itself a query) reports the query before it. The profile of the
+// running query is also appended to DuckDB's query profiler output (PRAGMA enable_profiling,
+// EXPLAIN ANALYZE) through WriteProfilingInformation.
+//
+// Attribution is by opener: FileSystem reads carry no client context, so a handle charges its
+// I/O to the client that opened it for as long as it lives. I/O on a handle another client
+// opened (a cached file handle, or a database file attached by one connection and read by
+// another) lands in the opener's profile, not in the reader's.
+class S3RedirectQueryProfile : public ClientContextState {
+public:
+	static constexpr const char *STATE_KEY = "cwiqduck_query_profile";
+
+	// Profile of the client behind `opener`; null when there is none (e.g. a background open). All
+	// I/O of the handle being opened is charged to it, whichever client later uses the handle.
+	static shared_ptr<S3RedirectQueryProfile> Get(optional_ptr<FileOpener> opener);
+
+	// Entry of `path`, created on first use. Entries are shared by all handles on the same path.
+	shared_ptr<S3RedirectFileProfile> GetFile(const string &path);
+	// Rows of the last finished query, by path.
+	vector<S3RedirectFileProfileRow> GetLastQuery();
+
+	void QueryBegin(ClientContext &context) override;
+	void QueryEnd(ClientContext &context) override;
+	void WriteProfilingInformation(std::ostream &ss) override;
+
+private:
+	// Rows of the files touched since the last QueryBegin. Expects `lock` to be held.
+	vector<S3RedirectFileProfileRow> SnapshotLocked();
+
+	std::mutex lock;
+	std::map<string, shared_ptr<S3RedirectFileProfile>> files;
+	vector<S3RedirectFileProfileRow> last_query;
+};
+
+} // namespace duckdb
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace duckdb {
+
+// Short-window read scheduler for the positional reads of one S3RedirectFileHandle.
+//
+// Parquet projection produces bursts of small reads at nearby offsets from different threads.
+// The first read of a burst opens a batch; if other reads are already in flight on the handle
+// it waits `window` for more to join, then the batch is closed and planned: reads sorted by
+// offset are merged into one group while the gap to the next read is at most `max_gap` and the
+// merged span stays within `max_span`. The first member of each group issues one GET for the
+// whole span and scatters it into every member's buffer; a group of one reads straight into the
+// caller's buffer. A read that arrives while nothing else is in flight pays no window.
+class S3RedirectReadCoalescer {
+public:
+	// Reads `nr_bytes` at `location` into `buffer`; throws on failure.
+	using fetch_function_t = std::function<void(data_ptr_t buffer, idx_t nr_bytes, idx_t location)>;
+
+	S3RedirectReadCoalescer(fetch_function_t fetch, std::chrono::microseconds window, idx_t max_gap,
+	                        idx_t max_span);
+
+	void Read(data_ptr_t buffer, idx_t nr_bytes, idx_t location);
+
+	idx_t GetMergedReads() const {
+		return merged_reads.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Group;
+
+	struct PendingRead {
+		data_ptr_t buffer;
+		idx_t nr_bytes;
+		idx_t location;
+		shared_ptr<Group> group;
+		bool done {false};
+		std::exception_ptr error;
+	};
+
+	struct Group {
+		idx_t start;
+		idx_t end;
+		// Sorted by location; members.front() issues the GET.
+		vector<PendingRead *> members;
+	};
+
+	struct Batch {
+		vector<PendingRead *> reads;
+		bool planned {false};
+	};
+
+	// Expects `lock` to be held.
+	void PlanLocked(Batch &batch);
+	void ExecuteGroup(Group &group);
+
+	fetch_function_t fetch;
+	std::chrono::microseconds window;
+	idx_t max_gap;
+	idx_t max_span;
+
+	std::mutex lock;
+	std::condition_variable changed;
+	shared_ptr<Batch> open_batch;
+	idx_t active_reads {0};
+
+	// Reads that were served by another read's GET.
+	std::atomic<idx_t> merged_reads {0};
+};
+
+} // namespace duckdb
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "s3redirect_task_pool.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace duckdb {
+
+// Adaptive sequential readahead for the S3RedirectFileHandle cursor (Read(buf, n) / Seek).
+//
+// The object is consumed as a queue of windows. While reads stay sequential, READAHEAD_DEPTH
+// windows beyond the one being consumed are fetched on the task pool, and every new window is
+// twice the size of the previous one up to the maximum, so a long CSV/JSON scan becomes
+// bandwidth-bound instead of paying one round trip per read. A non-sequential read or a Seek
+// drops the queued windows and restarts at the initial size.
+//
+// Like the cursor it serves, one instance is used by one thread at a time. If the consumer
+// reaches a window no worker has picked up yet it fetches that window itself, so a busy pool
+// never stalls the scan.
+class S3RedirectReadahead {
+public:
+	// Reads `nr_bytes` at `location` into `buffer`; throws on failure.
+	using fetch_function_t = std::function<void(data_ptr_t buffer, idx_t nr_bytes, idx_t location)>;
+
+	static constexpr idx_t READAHEAD_DEPTH = 2;
+
+	S3RedirectReadahead(S3RedirectTaskPool &task_pool, fetch_function_t fetch, idx_t file_size, idx_t initial_window,
+	                    idx_t max_window);
+	// Cancels queued windows and waits for the ones already running.
+	~S3RedirectReadahead();
+
+	// Sequential read at `position`; returns the bytes read (short only at end of file).
+	idx_t Read(data_ptr_t buffer, idx_t nr_bytes, idx_t position);
+	// Drops queued windows and restarts growth; called on Seek.
+	void Reset();
+
+private:
+	enum class WindowState { PENDING, RUNNING, DONE, CANCELLED };
+
+	struct Window {
+		idx_t offset;
+		idx_t length;
+		unsafe_unique_array<data_t> data;
+		std::mutex lock;
+		std::condition_variable done;
+		WindowState state {WindowState::PENDING};
+		std::exception_ptr error;
+	};
+
+	void ScheduleWindow(idx_t offset);
+	void FillQueue();
+	// Runs `window` if it is still pending; used by pool workers and by the consumer.
+	void RunWindow(Window &window);
+	void WaitForWindow(Window &window);
+
+	S3RedirectTaskPool &task_pool;
+	fetch_function_t fetch;
+	idx_t file_size;
+	idx_t initial_window;
+	idx_t max_window;
+
+	idx_t next_window_size;
+	// End of the previous read; a read starting anywhere else is not sequential.
+	idx_t expected_position {0};
+	std::deque<shared_ptr<Window>> windows;
+
+	// Windows handed to the pool that have not finished yet; the destructor waits for zero.
+	std::mutex in_flight_lock;
+	std::condition_variable in_flight_done;
+	idx_t in_flight {0};
+};
+
+} // namespace duckdb
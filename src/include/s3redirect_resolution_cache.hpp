@@ -0,0 +1,97 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "s3redirect_resolver.hpp"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Bounded, concurrent path -> S3RedirectResolution cache shared by CanHandleFile, FileExists and
+// OpenFile, in front of the configured S3RedirectResolver. Every lookup costs one stat(); the
+// inode, mtime, ctime and size it returns validate the cached entry (ctime moves when CWIQ FS
+// updates the xattrs, mtime does not), so a hit skips the resolver entirely - for the xattr
+// resolver the getxattr CWIQ FS cannot answer from the kernel attribute cache. Resolvers that
+// answer from memory (the manifest) are called directly instead. Entries are spread over
+// independently locked LRU shards so parallel glob/open threads rarely touch the same mutex, and
+// no lock is held across a syscall.
+class S3RedirectResolutionCache {
+public:
+	static constexpr idx_t DEFAULT_CAPACITY = 65536;
+
+	explicit S3RedirectResolutionCache(idx_t capacity = DEFAULT_CAPACITY);
+
+	// With probe_residency / probe_etag, the residency and ETag of a redirectable file are read
+	// once and cached with the entry, so repeated opens of the same file version do not probe again.
+	S3RedirectResolution Resolve(const string &local_path, bool probe_residency = false, bool probe_etag = false);
+	void SetCapacity(idx_t capacity);
+	void Clear();
+	// Switches to the named resolver (see S3RedirectResolver::Create) and drops the cached
+	// entries; a no-op when it is already in use with the same manifest path and namespace.
+	void SetResolver(const string &name, const string &manifest_path, const string &xattr_namespace);
+	// The resolver in use, from this thread's snapshot: one atomic load unless SetResolver
+	// switched resolvers since this thread last looked. Valid until this thread's next call.
+	S3RedirectResolver &GetResolver();
+
+	idx_t GetHits() const {
+		return hits.load(std::memory_order_relaxed);
+	}
+	idx_t GetMisses() const {
+		return misses.load(std::memory_order_relaxed);
+	}
+
+	// Uncached resolution through the xattr resolver: stat() plus a single getxattr() into a stack
+	// buffer.
+	static S3RedirectResolution ResolveUncached(const string &local_path);
+
+private:
+	static constexpr idx_t SHARD_COUNT = 16;
+
+	struct Entry {
+		uint64_t inode {0};
+		int64_t mtime_ns {0};
+		int64_t ctime_ns {0};
+		int64_t size {0};
+		S3RedirectResolution resolution;
+		std::list<string>::iterator lru_position;
+	};
+
+	struct Shard {
+		std::mutex lock;
+		// Front = most recently used.
+		std::list<string> lru;
+		std::unordered_map<string, Entry> entries;
+	};
+
+	Shard &GetShard(const string &local_path);
+	idx_t ShardCapacity() const;
+
+	Shard shards[SHARD_COUNT];
+	std::atomic<idx_t> capacity;
+	std::atomic<idx_t> hits {0};
+	std::atomic<idx_t> misses {0};
+
+	// A thread's copy of `resolver`, so resolving takes neither resolver_lock nor a reference
+	// count. A thread keeps the previous resolver (and a manifest's mapping) alive until it next
+	// resolves or exits.
+	struct ResolverSnapshot {
+		uint64_t cache_id {0};
+		idx_t generation {0};
+		shared_ptr<S3RedirectResolver> resolver;
+	};
+	static thread_local ResolverSnapshot resolver_snapshot;
+
+	const uint64_t cache_id;
+	// Bumped by every SetResolver that switches resolvers.
+	std::atomic<idx_t> resolver_generation {0};
+	std::mutex resolver_lock;
+	shared_ptr<S3RedirectResolver> resolver;
+	string resolver_name;
+	string resolver_manifest_path;
+	string resolver_xattr_namespace;
+};
+
+} // namespace duckdb
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Byte ranges of a redirected file that the CWIQ FS mount already holds locally, as reported by
+// the mount's residency xattr. Immutable once probed.
+struct S3RedirectResidency {
+	// Half-open [start, end) ranges, sorted and non-overlapping.
+	vector<std::pair<idx_t, idx_t>> ranges;
+
+	bool Empty() const {
+		return ranges.empty();
+	}
+	// Parses "all" (whole file), "none"/"" or a list "start-end,start-end" of half-open ranges.
+	// Malformed values are treated as nothing resident.
+	static shared_ptr<const S3RedirectResidency> Parse(const string &value, idx_t file_size);
+};
+
+struct S3RedirectInfo {
+	string s3_url;
+	idx_t content_length {0};
+	// Whole seconds, like S3's Last-Modified.
+	timestamp_t last_modified_time;
+	// The modification time as precisely as the resolver knows it.
+	int64_t mtime_ns {0};
+	// Null until probed; probing only happens when a file is opened with local-first reads on.
+	shared_ptr<const S3RedirectResidency> residency;
+	// The object's ETag exactly as S3 returns it (quotes included), when CWIQ FS exports it; empty
+	// when it does not. Only probed when a file is opened with seeded HTTP metadata, since httpfs
+	// checks every response against the ETag it was given.
+	string etag;
+	bool etag_probed {false};
+
+	// Identity of this object version in the block cache, single-flight table and disk cache: the
+	// URL, size, mtime_ns and, when known, the ETag. An object rewritten under the same URL gets a
+	// new key even within the same second.
+	string ObjectKey() const;
+};
+
+// Outcome of resolving a local path against CWIQ FS. Failures are kept as an errno rather than
+// thrown so that negative results (plain local files, no xattr support) can be cached too.
+struct S3RedirectResolution {
+	// Set when the xattr exists but holds an empty value; not a real errno.
+	static constexpr int EMPTY_XATTR_VALUE = -1;
+
+	// 0 when the path is redirectable, otherwise the errno of the failed stat/getxattr.
+	int error {0};
+	// True when `error` came from stat() rather than getxattr().
+	bool stat_failed {false};
+	// Replaces the xattr wording of ThrowError for resolvers that do not use xattrs.
+	string error_message;
+	// Name of the xattr whose getxattr() failed, for ThrowError; the default namespace's s3_url
+	// when empty.
+	string attribute;
+	S3RedirectInfo info;
+
+	bool IsRedirectable() const {
+		return error == 0;
+	}
+	// Throws the IOException ConvertLocalPathToS3 has always raised for this failure.
+	void ThrowError(const string &local_path) const;
+};
+
+// Source of the local path -> S3 object mapping, selected with cwiqduck_resolver.
+//
+// Resolvers that answer through the filesystem (xattr, batch) sit behind the resolution cache,
+// which stat()s every path to validate its entries and hands the result in. A resolver that
+// answers from memory (manifest) bypasses the cache and the stat altogether.
+class S3RedirectResolver {
+public:
+	virtual ~S3RedirectResolver() = default;
+
+	virtual const char *GetName() const = 0;
+	virtual bool UsesResolutionCache() const {
+		return true;
+	}
+	// Resolves a path the caller has already stat()ed as `st`.
+	virtual S3RedirectResolution Resolve(const string &local_path, const struct stat &st) = 0;
+	// Resolves a path without a prior stat; only called when UsesResolutionCache() is false.
+	virtual S3RedirectResolution Resolve(const string &local_path);
+	// Resident ranges of a redirectable file; nothing resident unless the backend knows better.
+	virtual shared_ptr<const S3RedirectResidency> ProbeResidency(const string &local_path, idx_t file_size);
+	// ETag of a redirectable file; empty (unknown) unless the backend knows better.
+	virtual string ProbeEtag(const string &local_path);
+
+	// "xattr", "manifest" or "batch"; throws InvalidInputException for anything else. The xattr
+	// namespace only matters to the xattr and batch resolvers.
+	static unique_ptr<S3RedirectResolver> Create(const string &name, const string &manifest_path,
+	                                             const string &xattr_namespace);
+};
+
+// One getxattr(<namespace>.s3_url) per file: what a CWIQ FS mount answers natively. The namespace
+// is system.cwiqfs, which only the mount itself can set, unless cwiqduck_xattr_namespace says
+// otherwise.
+class S3RedirectXattrResolver : public S3RedirectResolver {
+public:
+	static constexpr const char *NAME = "xattr";
+	static constexpr const char *DEFAULT_NAMESPACE = "system.cwiqfs";
+
+	explicit S3RedirectXattrResolver(const string &xattr_namespace = DEFAULT_NAMESPACE);
+
+	const char *GetName() const override {
+		return NAME;
+	}
+	S3RedirectResolution Resolve(const string &local_path, const struct stat &st) override;
+	using S3RedirectResolver::Resolve;
+	shared_ptr<const S3RedirectResidency> ProbeResidency(const string &local_path, idx_t file_size) override;
+	// <namespace>.etag, when the mount sets it.
+	string ProbeEtag(const string &local_path) override;
+
+	// Reads <namespace>.<attribute>; returns 0 or an errno.
+	int ReadAttribute(const string &local_path, const char *attribute, string &result) const;
+
+protected:
+	const string xattr_namespace;
+	// <namespace>.s3_url
+	const string s3_url_attribute;
+};
+
+// Resolves a whole directory from its <namespace>.dir_s3_urls xattr, which lists
+// "name<TAB>s3_url" per line for every redirectable entry. Listings are kept per directory and
+// reloaded when the directory's inode, mtime or ctime changes, so a glob over thousands of
+// siblings costs a few round trips into the daemon instead of one per file. Directories without
+// the listing attribute fall back to per-file xattrs.
+//
+// Linux caps an xattr value at 64 KiB (XATTR_SIZE_MAX), about 600 entries of typical length, so
+// the mount pages longer listings: it splits them at line boundaries over dir_s3_urls,
+// dir_s3_urls.1, dir_s3_urls.2, ..., ending every page but the last with a line holding only
+// LISTING_CONTINUATION. At most MAX_LISTING_PAGES pages are read; a listing that promises more,
+// or whose next page is missing, is treated as no listing at all.
+class S3RedirectBatchResolver : public S3RedirectXattrResolver {
+public:
+	static constexpr const char *NAME = "batch";
+	// Listings kept at once; all are dropped when the limit is reached.
+	static constexpr idx_t MAX_LISTINGS = 4096;
+	static constexpr const char *LISTING_CONTINUATION = "+";
+	static constexpr idx_t MAX_LISTING_PAGES = 1024;
+
+	using S3RedirectXattrResolver::S3RedirectXattrResolver;
+
+	const char *GetName() const override {
+		return NAME;
+	}
+	S3RedirectResolution Resolve(const string &local_path, const struct stat &st) override;
+	using S3RedirectResolver::Resolve;
+
+private:
+	struct Listing {
+		std::mutex lock;
+		bool loaded {false};
+		uint64_t inode {0};
+		int64_t mtime_ns {0};
+		int64_t ctime_ns {0};
+		// errno of the failed getxattr; the directory then falls back to per-file lookups.
+		int error {0};
+		std::unordered_map<string, string> urls;
+	};
+
+	shared_ptr<Listing> GetListing(const string &directory);
+	// Reads every page of the listing of `directory` into `urls`; returns 0 or an errno.
+	int LoadListing(const string &directory, std::unordered_map<string, string> &urls) const;
+
+	std::mutex lock;
+	std::unordered_map<string, shared_ptr<Listing>> listings;
+};
+
+// Looks paths up in a manifest file exported by CWIQ FS, memory-mapped and indexed by an open
+// addressing hash table over its lines, so a lookup is O(1) and makes no syscalls. Each line is
+// "local_path<TAB>s3_url<TAB>size<TAB>mtime_epoch_seconds[<TAB>etag]"; malformed lines are
+// skipped. The file is re-stat()ed at most once per RECHECK_INTERVAL and remapped when it was
+// replaced. Each thread keeps its own reference to the current mapping, so a lookup takes no lock.
+//
+// The manifest must be replaced atomically: write the new version to a temp file in the same
+// directory and rename() it over the old one. Readers keep the old inode mapped until they are
+// done. A manifest truncated or rewritten in place changes pages under the mapping, and a lookup
+// that touches a page past the new end of file kills the process with SIGBUS.
+class S3RedirectManifestResolver : public S3RedirectResolver {
+public:
+	static constexpr const char *NAME = "manifest";
+	static constexpr int64_t RECHECK_INTERVAL_US = 1000000;
+
+	explicit S3RedirectManifestResolver(string manifest_path);
+
+	const char *GetName() const override {
+		return NAME;
+	}
+	bool UsesResolutionCache() const override {
+		return false;
+	}
+	S3RedirectResolution Resolve(const string &local_path) override;
+	S3RedirectResolution Resolve(const string &local_path, const struct stat &st) override {
+		return Resolve(local_path);
+	}
+
+private:
+	struct Mapping;
+
+	// One entry per thread, like the mount table's snapshot cache.
+	struct MappingCache {
+		uint64_t resolver_id {0};
+		idx_t generation {0};
+		shared_ptr<const Mapping> mapping;
+	};
+	static thread_local MappingCache mapping_cache;
+
+	// Maps and indexes the manifest; a failure is kept in the mapping's error.
+	static shared_ptr<const Mapping> Load(const string &path);
+	const Mapping &GetMapping();
+
+	const string manifest_path;
+	// Distinguishes this resolver in thread-local caches, which outlive it.
+	const uint64_t resolver_id;
+	std::mutex lock;
+	shared_ptr<const Mapping> mapping;
+	// Bumped whenever `mapping` is replaced.
+	std::atomic<idx_t> generation {0};
+	// Steady-clock time (us) of the next stat() of the manifest; 0 forces one.
+	std::atomic<int64_t> next_check_us {0};
+};
+
+} // namespace duckdb
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+class DBConfig;
+
+// Snapshot of the cwiqduck_* options. Options are registered once from LoadInternal with GLOBAL
+// scope, so a SET applies to every connection of the database (SET SESSION and SET LOCAL are
+// rejected), and are read at OpenFile time, so it takes effect for files opened afterwards.
+struct S3RedirectSettings {
+	static constexpr const char *RESOLUTION_CACHE_ENTRIES = "cwiqduck_resolution_cache_entries";
+	static constexpr const char *SEED_HTTP_METADATA = "cwiqduck_seed_http_metadata";
+	static constexpr const char *POOL_MAX_HANDLES_PER_OBJECT = "cwiqduck_pool_max_handles_per_object";
+	static constexpr const char *POOL_MAX_HANDLES = "cwiqduck_pool_max_handles";
+	static constexpr const char *POOL_TARGET_HANDLES = "cwiqduck_pool_target_handles";
+	static constexpr const char *POOL_IDLE_TIMEOUT_MS = "cwiqduck_pool_idle_timeout_ms";
+	static constexpr const char *BLOCK_CACHE_SIZE = "cwiqduck_block_cache_size";
+	static constexpr const char *BLOCK_CACHE_BLOCK_SIZE = "cwiqduck_block_cache_block_size";
+	static constexpr const char *DISK_CACHE_PATH = "cwiqduck_disk_cache_path";
+	static constexpr const char *DISK_CACHE_SIZE = "cwiqduck_disk_cache_size";
+	static constexpr const char *IO_THREADS = "cwiqduck_io_threads";
+	static constexpr const char *READAHEAD_INITIAL_WINDOW = "cwiqduck_readahead_initial_window";
+	static constexpr const char *READAHEAD_MAX_WINDOW = "cwiqduck_readahead_max_window";
+	static constexpr const char *PARALLEL_READ_THRESHOLD = "cwiqduck_parallel_read_threshold";
+	static constexpr const char *PARALLEL_READ_PART_SIZE = "cwiqduck_parallel_read_part_size";
+	static constexpr const char *PARALLEL_READ_MAX_PARTS = "cwiqduck_parallel_read_max_parts";
+	static constexpr const char *COALESCE_WINDOW_US = "cwiqduck_coalesce_window_us";
+	static constexpr const char *COALESCE_MAX_GAP = "cwiqduck_coalesce_max_gap";
+	static constexpr const char *SINGLE_FLIGHT = "cwiqduck_single_flight";
+	static constexpr const char *HEDGED_READS = "cwiqduck_hedged_reads";
+	static constexpr const char *HEDGE_PERCENTILE = "cwiqduck_hedge_percentile";
+	static constexpr const char *HEDGE_MAX_RATIO = "cwiqduck_hedge_max_ratio";
+	static constexpr const char *HEDGE_MIN_DELAY_MS = "cwiqduck_hedge_min_delay_ms";
+	static constexpr const char *LOCAL_FIRST = "cwiqduck_local_first";
+	static constexpr const char *GLOB_THREADS = "cwiqduck_glob_threads";
+	static constexpr const char *PARQUET_FOOTER_PREFETCH = "cwiqduck_parquet_footer_prefetch";
+	static constexpr const char *PREFETCH_BUDGET = "cwiqduck_prefetch_budget";
+	static constexpr const char *MAX_IN_FLIGHT = "cwiqduck_max_in_flight";
+	static constexpr const char *MAX_IN_FLIGHT_PER_ENDPOINT = "cwiqduck_max_in_flight_per_endpoint";
+	static constexpr const char *RESOLVER = "cwiqduck_resolver";
+	static constexpr const char *MANIFEST_PATH = "cwiqduck_manifest_path";
+	static constexpr const char *XATTR_NAMESPACE = "cwiqduck_xattr_namespace";
+	static constexpr const char *SMALL_OBJECT_THRESHOLD = "cwiqduck_small_object_threshold";
+	static constexpr const char *WRITE_BUFFER_SIZE = "cwiqduck_write_buffer_size";
+	static constexpr const char *MOUNT_FILESYSTEM_TYPE = "cwiqduck_mount_filesystem_type";
+	static constexpr const char *MOUNT_PATHS = "cwiqduck_mount_paths";
+
+	// Max cached path resolutions (positive and negative); 0 disables the cache.
+	idx_t resolution_cache_entries = 65536;
+	// Pass the size, mtime and ETag known from CWIQ FS to httpfs instead of letting every handle
+	// open send a HEAD. Files whose ETag CWIQ FS does not export are always opened with a HEAD.
+	bool seed_http_metadata = true;
+	// Caps on idle httpfs handles kept in the DB-wide pool; 0 disables pooling.
+	idx_t pool_max_handles_per_object = 16;
+	idx_t pool_max_handles = 256;
+	// Idle handles the background reaper shrinks the pool back to after a burst of reads.
+	idx_t pool_target_handles = 32;
+	// Idle handles older than this are closed by the reaper or the next time the pool is used.
+	idx_t pool_idle_timeout_ms = 30000;
+	// Memory budget (bytes) of the positional-read block cache; 0, the default, disables it. Blocks
+	// are allocated outside DuckDB's buffer manager and do not count against memory_limit, so the
+	// budget comes on top of it; cwiqduck_stats() reports the bytes held as block_cache_size_bytes.
+	idx_t block_cache_size = 0;
+	// Alignment and granularity (bytes) of cached blocks.
+	idx_t block_cache_block_size = idx_t(512) << 10;
+	// Directory of the persistent on-disk chunk cache; empty disables it.
+	string disk_cache_path;
+	// Size cap (bytes) of the on-disk cache; least recently used chunks are evicted beyond it.
+	idx_t disk_cache_size = idx_t(64) << 30;
+	// Upper bound on background I/O threads (readahead and prefetch).
+	idx_t io_threads = 32;
+	// Sequential readahead window: starts at the initial size and doubles up to the max while
+	// reads stay sequential. A max of 0 disables readahead (reads go to the primary handle).
+	idx_t readahead_initial_window = idx_t(256) << 10;
+	idx_t readahead_max_window = idx_t(16) << 20;
+	// Positional reads of at least the threshold are split into part-size-aligned ranged GETs,
+	// at most max_parts in flight at once. max_parts <= 1 disables splitting.
+	idx_t parallel_read_threshold = idx_t(8) << 20;
+	idx_t parallel_read_part_size = idx_t(4) << 20;
+	idx_t parallel_read_max_parts = 8;
+	// Concurrent positional reads of one file arriving within the window are merged into one GET
+	// when the gap between them is at most max_gap bytes; merged GETs stay below the parallel
+	// read threshold. A window of 0 disables coalescing.
+	idx_t coalesce_window_us = 200;
+	idx_t coalesce_max_gap = idx_t(64) << 10;
+	// Concurrent reads of the same range of the same object share one GET.
+	bool single_flight = true;
+	// Opt-in hedging: a range GET still running after the endpoint's latency percentile (and at
+	// least min_delay) gets a duplicate on another handle. Hedges are capped at max_ratio percent
+	// of the endpoint's reads.
+	bool hedged_reads = false;
+	idx_t hedge_percentile = 95;
+	idx_t hedge_max_ratio = 5;
+	idx_t hedge_min_delay_ms = 5;
+	// Ask the mount which byte ranges it already holds (probed once per file version at open)
+	// and read those from the local file instead of S3.
+	bool local_first = true;
+	// Threads (the caller included) resolving glob matches in parallel.
+	idx_t glob_threads = 16;
+	// Bytes at the end of a .parquet file fetched in the background as soon as it is opened;
+	// 0 disables the footer prefetch.
+	idx_t parquet_footer_prefetch = idx_t(1) << 20;
+	// Bytes of prefetched data one open file may hold; 0 disables prefetching altogether.
+	idx_t prefetch_budget = idx_t(64) << 20;
+	// Caps on concurrent range GETs, overall and per endpoint (bucket). Waiting reads are shared
+	// fairly across client contexts, and an endpoint's cap shrinks while it throttles. A global
+	// cap of 0 disables admission control; a per-endpoint cap of 0 leaves only the global one.
+	idx_t max_in_flight = 256;
+	idx_t max_in_flight_per_endpoint = 128;
+	// Where path -> S3 object mappings come from: "xattr" (one getxattr per file), "batch" (one
+	// getxattr per directory) or "manifest" (lookups in the memory-mapped file at manifest_path,
+	// which must be replaced with rename(), never rewritten in place).
+	string resolver = "xattr";
+	string manifest_path;
+	// Namespace of the xattrs the xattr and batch resolvers read. Only the mount can set system.*
+	// attributes; in a namespace file owners can write (user.*), anyone who can create a file
+	// can point its reads at any object the database's credentials reach. Meant for test and
+	// benchmark fixtures on ordinary filesystems; pin it with lock_configuration elsewhere.
+	string xattr_namespace = "system.cwiqfs";
+	// Objects of at most this many bytes are downloaded whole with one GET started at open and
+	// every read is served from memory; 0 disables it.
+	idx_t small_object_threshold = idx_t(256) << 10;
+	// Write-only opens of files on a CWIQ FS mount (COPY output, exports) gather their writes into
+	// aligned buffers of this many bytes, flushed in the background. Off (0) by default, which
+	// leaves every write to the local filesystem; read-write opens (database files, WALs) are
+	// never buffered.
+	idx_t write_buffer_size = 0;
+	// What counts as a CWIQ FS mount (for write buffering and globs): mounts in /proc/self/mounts
+	// of exactly this filesystem type (empty: none), plus the comma-separated directories of
+	// mount_paths.
+	string mount_filesystem_type = "fuse.cwiqfs";
+	string mount_paths;
+
+	static void Register(DBConfig &config);
+	static S3RedirectSettings Fetch(DatabaseInstance &db);
+	// Only the options read outside OpenFile, by CanHandleFile, FileExists and Glob: the resolver
+	// options, the write buffer size and the mount options.
+	static void FetchPathSettings(DatabaseInstance &db, S3RedirectSettings &settings);
+	// Bumped by every SET (or RESET) of an option FetchPathSettings reads. Path handling runs far
+	// more often than OpenFile, so the filesystem only fetches them again when this moved.
+	// Process-wide: a SET in one database makes the others re-read their (unchanged) options
+	// once, which is harmless.
+	static idx_t GetPathSettingsGeneration();
+	// mount_paths split on commas, blanks trimmed.
+	vector<string> GetMountPaths() const;
+};
+
+} // namespace duckdb
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Database-wide single-flight table for range GETs of redirected objects. Keys are
+// (object key, offset, length), the object key being the S3 URL qualified by the last-modified
+// time as in the block cache. The first caller of a key becomes the leader and fetches straight
+// into its own buffer; callers of the same key that arrive while it is in flight wait and copy
+// the leader's bytes instead of issuing their own GET. The entry is removed when the fetch
+// completes, so nothing is cached beyond the flight itself (the block cache covers that).
+//
+// The leader only pays for a copy of its result when someone actually joined. Errors are shared:
+// every waiter of a failed flight rethrows the leader's exception.
+class S3RedirectSingleFlight {
+public:
+	static constexpr idx_t SHARD_COUNT = 16;
+
+	// Fills `buffer` with the requested range; called by the leader only.
+	using fetch_function_t = std::function<void(data_ptr_t buffer)>;
+
+	void Read(const string &object_key, idx_t location, idx_t nr_bytes, data_ptr_t buffer,
+	          const fetch_function_t &fetch);
+
+	// Fetches issued by leaders, and reads that were served by another caller's fetch.
+	idx_t GetLeaders() const {
+		return leaders.load(std::memory_order_relaxed);
+	}
+	idx_t GetShared() const {
+		return shared.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct FlightKey {
+		string object_key;
+		idx_t location;
+		idx_t nr_bytes;
+
+		bool operator==(const FlightKey &other) const {
+			return location == other.location && nr_bytes == other.nr_bytes && object_key == other.object_key;
+		}
+	};
+	struct FlightKeyHash {
+		size_t operator()(const FlightKey &key) const;
+	};
+	struct Flight {
+		// Guarded by the shard lock; final once the flight is removed from the table.
+		idx_t waiters {0};
+		// Guarded by `lock`.
+		std::mutex lock;
+		std::condition_variable finished;
+		bool done {false};
+		std::exception_ptr error;
+		unsafe_unique_array<data_t> result;
+	};
+	struct Shard {
+		std::mutex lock;
+		std::unordered_map<FlightKey, shared_ptr<Flight>, FlightKeyHash> flights;
+	};
+
+	Shard &GetShard(const FlightKey &key);
+
+	Shard shards[SHARD_COUNT];
+	std::atomic<idx_t> leaders {0};
+	std::atomic<idx_t> shared {0};
+};
+
+} // namespace duckdb
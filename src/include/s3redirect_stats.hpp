@@ -0,0 +1,83 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Lock-free latency histogram with power-of-two microsecond buckets: bucket b counts durations in
+// [2^(b-1), 2^b) us. Percentiles interpolate linearly inside the bucket, which is plenty to tell a
+// 5 ms GET from a 50 ms one.
+class S3RedirectLatencyHistogram {
+public:
+	static constexpr idx_t BUCKET_COUNT = 40;
+
+	void Record(idx_t micros);
+	void Reset();
+
+	idx_t GetCount() const {
+		return count.load(std::memory_order_relaxed);
+	}
+	// Estimated percentile (0-100) in microseconds; 0 when nothing was recorded.
+	double Percentile(double percentile) const;
+
+private:
+	std::atomic<idx_t> buckets[BUCKET_COUNT] = {};
+	std::atomic<idx_t> count {0};
+};
+
+// One row of cwiqduck_stats(). Counters and gauges carry a value only; operations also carry the
+// bytes they moved and their latency percentiles.
+struct S3RedirectStatRow {
+	string name;
+	idx_t value;
+	bool is_operation;
+	idx_t bytes;
+	double p50_us;
+	double p99_us;
+};
+
+// Always-on metrics of the redirect filesystem, read by cwiqduck_stats() and cleared by
+// cwiqduck_stats_reset(). Recording is a couple of relaxed atomic increments, cheap enough for
+// every read.
+//
+// Operations (opens, resolutions, reads, GETs) are recorded here directly. Counters owned by the
+// individual components (cache hits, pool misses, ...) stay where they are; the filesystem passes
+// their current values to Snapshot()/Reset(), and a reset only records a baseline that later
+// snapshots subtract, so components never need a reset path of their own.
+class S3RedirectStats {
+public:
+	enum class Operation : uint8_t { OPEN, RESOLVE, POSITIONAL_READ, SEQUENTIAL_READ, GET, LOCAL_READ };
+	static constexpr idx_t OPERATION_COUNT = 6;
+
+	using counter_list_t = vector<std::pair<string, idx_t>>;
+
+	void Record(Operation operation, idx_t micros, idx_t bytes = 0) {
+		auto index = static_cast<idx_t>(operation);
+		latencies[index].Record(micros);
+		operation_bytes[index].fetch_add(bytes, std::memory_order_relaxed);
+	}
+	// Counters kept only here rather than in a component.
+	void AddCoalescedReads(idx_t count) {
+		coalesced_reads.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	// `counters` are monotonic and reported relative to the last reset; `gauges` as they are.
+	vector<S3RedirectStatRow> Snapshot(const counter_list_t &counters, const counter_list_t &gauges);
+	void Reset(const counter_list_t &counters);
+
+	static const char *OperationName(Operation operation);
+
+private:
+	S3RedirectLatencyHistogram latencies[OPERATION_COUNT];
+	std::atomic<idx_t> operation_bytes[OPERATION_COUNT] = {};
+	std::atomic<idx_t> coalesced_reads {0};
+
+	std::mutex baseline_lock;
+	std::unordered_map<string, idx_t> baselines;
+};
+
+} // namespace duckdb
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace duckdb {
+
+// Small database-wide thread pool for background redirect I/O (readahead, split reads, prefetches).
+// DuckDB's TaskScheduler threads run query pipelines and must not block on network I/O we start
+// speculatively, so these tasks get their own threads. Workers are spawned lazily up to the
+// configured count, so a database that never reads sequentially never starts one.
+//
+// Tasks must not throw (errors belong to whoever waits on the task's result) and must not wait on
+// other tasks of this pool; callers that wait on a task either run it themselves when it has not
+// started yet or only wait on tasks that are already running.
+class S3RedirectTaskPool {
+public:
+	static constexpr idx_t DEFAULT_THREAD_COUNT = 32;
+
+	~S3RedirectTaskPool();
+
+	void SetMaxThreads(idx_t max_threads);
+	void Schedule(std::function<void()> task);
+
+	// Runs body(0) .. body(count - 1) on up to `parallelism` threads, the caller included, and
+	// returns once every index has run; the first exception is rethrown. The caller claims work
+	// like any helper, so this completes even when no pool thread is free. Helpers that start
+	// after all indexes are claimed exit without touching `body`'s captures.
+	void ParallelFor(idx_t count, idx_t parallelism, const std::function<void(idx_t)> &body);
+
+private:
+	void WorkerLoop();
+
+	std::mutex lock;
+	std::condition_variable task_available;
+	std::deque<std::function<void()>> queue;
+	vector<std::thread> workers;
+	idx_t idle_workers {0};
+	idx_t max_threads {DEFAULT_THREAD_COUNT};
+	bool shutdown {false};
+};
+
+} // namespace duckdb
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "s3redirect_task_pool.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace duckdb {
+
+// Write-behind buffering for files written on the CWIQ FS mount, where every write() is a round
+// trip into the FUSE daemon. Writes are gathered into a buffer of `buffer_size` bytes whose end
+// is aligned to a multiple of the buffer size in the file, so flushes land on the same aligned
+// boundaries however the writer chunks its output. A full buffer (or a write that does not
+// continue the buffered run) is handed to the task pool and written while the next one fills;
+// at most one flush is in flight, so data reaches the file in the order it was written and a
+// later write to the same range always wins. Writes of at least a whole buffer go straight
+// through once the earlier data is out.
+//
+// The error of a background flush is rethrown when the writer next waits for it: when the next
+// buffer is submitted or on Flush(). Not thread-safe: S3RedirectWriteHandle serializes every call
+// under its own lock.
+class S3RedirectWriteBuffer {
+public:
+	// Writes `nr_bytes` of `data` at `location`; throws on failure.
+	using write_function_t = std::function<void(const_data_ptr_t data, idx_t nr_bytes, idx_t location)>;
+
+	S3RedirectWriteBuffer(S3RedirectTaskPool &task_pool, write_function_t write, idx_t buffer_size);
+	// Waits for the flush in flight (running it here if no worker picked it up). Data still being
+	// gathered is dropped: callers Flush() first.
+	~S3RedirectWriteBuffer();
+
+	void Write(const_data_ptr_t data, idx_t nr_bytes, idx_t location);
+	// Writes out everything buffered and waits for it.
+	void Flush();
+	// End of the buffered or in-flight data, 0 when there is none; the file size is at least this.
+	idx_t BufferedEnd() const;
+
+private:
+	enum class FlushState { PENDING, RUNNING, DONE };
+
+	struct PendingFlush {
+		unsafe_unique_array<data_t> data;
+		idx_t location {0};
+		idx_t size {0};
+		std::mutex lock;
+		std::condition_variable done;
+		FlushState state {FlushState::PENDING};
+		std::exception_ptr error;
+	};
+
+	// Runs `flush` if it is still pending; used by pool workers and by the writing thread.
+	static void RunFlush(PendingFlush &flush, const write_function_t &write);
+	// Waits for the flush in flight, recycles its buffer and rethrows its error.
+	void WaitForFlush();
+	// Hands the filling buffer to the pool after the previous flush has finished.
+	void SubmitFilling();
+
+	S3RedirectTaskPool &task_pool;
+	write_function_t write;
+	idx_t buffer_size;
+
+	// Buffer being filled: `filling_size` bytes at `filling_location`, at most `filling_capacity`.
+	unsafe_unique_array<data_t> filling;
+	idx_t filling_location {0};
+	idx_t filling_size {0};
+	idx_t filling_capacity {0};
+	// Buffer of the last finished flush, reused for the next fill.
+	unsafe_unique_array<data_t> spare;
+	shared_ptr<PendingFlush> in_flight;
+	idx_t in_flight_end {0};
+};
+
+} // namespace duckdb
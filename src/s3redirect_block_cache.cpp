@@ -0,0 +1,88 @@
+#include "s3redirect_block_cache.hpp"
+
+namespace duckdb {
+
+size_t S3RedirectBlockCache::BlockKeyHash::operator()(const BlockKey &key) const {
+	auto h = std::hash<string>()(key.object_key);
+	h ^= std::hash<idx_t>()(key.block_index) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	h ^= std::hash<idx_t>()(key.block_size) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	return h;
+}
+
+S3RedirectBlockCache::Shard &S3RedirectBlockCache::GetShard(const BlockKey &key) {
+	return shards[BlockKeyHash()(key) % SHARD_COUNT];
+}
+
+void S3RedirectBlockCache::SetCapacity(idx_t capacity_bytes) {
+	auto previous = capacity.exchange(capacity_bytes, std::memory_order_relaxed);
+	if (capacity_bytes == 0 && previous != 0) {
+		Clear();
+	}
+	// A smaller non-zero budget is enforced lazily, shard by shard, on the next Put.
+}
+
+shared_ptr<const S3RedirectBlock> S3RedirectBlockCache::Get(const string &object_key, idx_t block_size,
+                                                           idx_t block_index) {
+	BlockKey key {object_key, block_size, block_index};
+	auto &shard = GetShard(key);
+	{
+		std::lock_guard<std::mutex> lk(shard.lock);
+		auto it = shard.entries.find(key);
+		if (it != shard.entries.end()) {
+			shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_position);
+			hits.fetch_add(1, std::memory_order_relaxed);
+			return it->second.block;
+		}
+	}
+	misses.fetch_add(1, std::memory_order_relaxed);
+	return nullptr;
+}
+
+void S3RedirectBlockCache::Put(const string &object_key, idx_t block_size, idx_t block_index,
+                               shared_ptr<const S3RedirectBlock> block) {
+	auto shard_capacity = capacity.load(std::memory_order_relaxed) / SHARD_COUNT;
+	if (!block || block->size > shard_capacity) {
+		return;
+	}
+	BlockKey key {object_key, block_size, block_index};
+	auto &shard = GetShard(key);
+	// Evicted blocks are released after the lock is dropped; a reader may still hold them.
+	vector<shared_ptr<const S3RedirectBlock>> evicted;
+	{
+		std::lock_guard<std::mutex> lk(shard.lock);
+		auto it = shard.entries.find(key);
+		if (it != shard.entries.end()) {
+			// Another thread fetched the same block concurrently; keep the published copy.
+			shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_position);
+			return;
+		}
+		while (!shard.lru.empty() && shard.size_bytes + block->size > shard_capacity) {
+			auto victim = shard.entries.find(shard.lru.back());
+			D_ASSERT(victim != shard.entries.end());
+			shard.size_bytes -= victim->second.block->size;
+			size_bytes.fetch_sub(victim->second.block->size, std::memory_order_relaxed);
+			evicted.push_back(std::move(victim->second.block));
+			shard.entries.erase(victim);
+			shard.lru.pop_back();
+		}
+		shard.lru.push_front(key);
+		auto &entry = shard.entries[key];
+		entry.lru_position = shard.lru.begin();
+		shard.size_bytes += block->size;
+		size_bytes.fetch_add(block->size, std::memory_order_relaxed);
+		entry.block = std::move(block);
+	}
+	evictions.fetch_add(evicted.size(), std::memory_order_relaxed);
+}
+
+void S3RedirectBlockCache::Clear() {
+	for (auto &shard : shards) {
+		std::lock_guard<std::mutex> lk(shard.lock);
+		size_bytes.fetch_sub(shard.size_bytes, std::memory_order_relaxed);
+		shard.size_bytes = 0;
+		shard.entries.clear();
+		shard.lru.clear();
+	}
+}
+
+} // namespace duckdb
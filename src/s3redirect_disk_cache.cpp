@@ -0,0 +1,473 @@
+#include "s3redirect_disk_cache.hpp"
+
+#include "duckdb/common/checksum.hpp"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <errno.h>
+
+namespace duckdb {
+
+static constexpr char INDEX_MAGIC[8] = {'C', 'W', 'Q', 'D', 'C', '0', '2', '\0'};
+static constexpr const char *INDEX_FILE_NAME = "index.bin";
+// flock()ed around index flushes; its content is irrelevant.
+static constexpr const char *INDEX_LOCK_FILE_NAME = "index.lock";
+static constexpr const char *CHUNK_SUFFIX = ".chunk";
+static constexpr const char *TEMP_INFIX = ".tmp.";
+
+struct DiskCacheIndexHeader {
+	char magic[8];
+	uint64_t chunk_size;
+	uint64_t access_clock;
+	uint64_t entry_count;
+};
+
+struct DiskCacheIndexRecord {
+	uint64_t object_hash;
+	uint64_t chunk_index;
+	uint64_t last_access;
+	uint64_t checksum;
+	uint32_t size;
+	uint32_t reserved;
+};
+
+#ifdef __linux__
+// Reads a file that must be exactly `size` bytes long.
+static bool ReadFileExact(const string &path, data_ptr_t target, idx_t size) {
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || idx_t(st.st_size) != size) {
+		close(fd);
+		return false;
+	}
+	idx_t done = 0;
+	while (done < size) {
+		auto n = pread(fd, target + done, size - done, off_t(done));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		done += idx_t(n);
+	}
+	close(fd);
+	return done == size;
+}
+
+// Writes `data` to a temp file next to `path` and renames it into place. When `durable`, the data
+// and then the rename are fsync()ed, so the file survives a crash whole or not at all.
+static bool WriteFileAtomic(const string &path, const string &temp_path, const_data_ptr_t data, idx_t size,
+                            bool durable) {
+	int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	idx_t done = 0;
+	while (done < size) {
+		auto n = pwrite(fd, data + done, size - done, off_t(done));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		done += idx_t(n);
+	}
+	bool ok = done == size && (!durable || fsync(fd) == 0);
+	ok = close(fd) == 0 && ok && rename(temp_path.c_str(), path.c_str()) == 0;
+	if (!ok) {
+		unlink(temp_path.c_str());
+		return false;
+	}
+	if (durable) {
+		auto slash = path.rfind('/');
+		int dir_fd = open(slash == string::npos ? "." : path.substr(0, slash).c_str(), O_RDONLY | O_CLOEXEC);
+		if (dir_fd >= 0) {
+			fsync(dir_fd);
+			close(dir_fd);
+		}
+	}
+	return true;
+}
+
+// Creates `path` and every missing parent. Returns 0 or the errno of the step that failed.
+static int CreateDirectories(const string &path) {
+	for (auto slash = path.find('/', 1);; slash = path.find('/', slash + 1)) {
+		auto prefix = path.substr(0, slash);
+		if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+			return errno;
+		}
+		if (slash == string::npos) {
+			break;
+		}
+	}
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) {
+		return errno;
+	}
+	return S_ISDIR(st.st_mode) ? 0 : ENOTDIR;
+}
+
+// Reads an index written by Flush(); false when it is missing, torn or of another format.
+static bool ReadIndex(const string &path, DiskCacheIndexHeader &header, vector<DiskCacheIndexRecord> &records) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0 || idx_t(st.st_size) < sizeof(DiskCacheIndexHeader)) {
+		return false;
+	}
+	auto data = make_unsafe_uniq_array_uninitialized<data_t>(st.st_size);
+	if (!ReadFileExact(path, data.get(), st.st_size)) {
+		return false;
+	}
+	memcpy(&header, data.get(), sizeof(header));
+	if (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+	    header.chunk_size != S3RedirectDiskCache::CHUNK_SIZE ||
+	    sizeof(header) + header.entry_count * sizeof(DiskCacheIndexRecord) != idx_t(st.st_size)) {
+		return false;
+	}
+	records.resize(header.entry_count);
+	memcpy(records.data(), data.get() + sizeof(header), header.entry_count * sizeof(DiskCacheIndexRecord));
+	return true;
+}
+#endif
+
+S3RedirectDiskCache::~S3RedirectDiskCache() {
+	Flush();
+}
+
+uint64_t S3RedirectDiskCache::ChunkChecksum(const_data_ptr_t data, idx_t size) {
+	return Checksum(const_cast<data_ptr_t>(data), size);
+}
+
+uint64_t S3RedirectDiskCache::ObjectHash(const string &object_key) {
+	// FNV-1a: stable across processes and DuckDB versions, unlike std::hash.
+	uint64_t hash = 14695981039346656037ULL;
+	for (auto c : object_key) {
+		hash ^= uint8_t(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+string S3RedirectDiskCache::ChunkPath(const string &dir, const ChunkKey &key) const {
+	char name[64];
+	snprintf(name, sizeof(name), "%016" PRIx64 "-%" PRIu64 "%s", key.object_hash, key.chunk_index, CHUNK_SUFFIX);
+	return dir + "/" + name;
+}
+
+string S3RedirectDiskCache::IndexPath(const string &dir) const {
+	return dir + "/" + INDEX_FILE_NAME;
+}
+
+string S3RedirectDiskCache::TempPath(const string &path) {
+#ifdef __linux__
+	auto pid = std::to_string(getpid());
+#else
+	string pid = "0";
+#endif
+	return path + TEMP_INFIX + pid + "." + std::to_string(temp_file_counter.fetch_add(1));
+}
+
+void S3RedirectDiskCache::InsertLocked(const ChunkKey &key, uint32_t size, uint64_t checksum,
+                                       uint64_t last_access) {
+	lru.push_front(key);
+	auto &entry = entries[key];
+	entry.size = size;
+	entry.checksum = checksum;
+	entry.last_access = last_access;
+	entry.lru_position = lru.begin();
+	size_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void S3RedirectDiskCache::RemoveLocked(const ChunkKey &key, vector<string> &unlink_paths) {
+	auto it = entries.find(key);
+	if (it == entries.end()) {
+		return;
+	}
+	size_bytes.fetch_sub(it->second.size, std::memory_order_relaxed);
+	lru.erase(it->second.lru_position);
+	entries.erase(it);
+	evicted_since_flush.insert(key);
+	unlink_paths.push_back(ChunkPath(directory, key));
+}
+
+string S3RedirectDiskCache::Configure(const string &directory_p, idx_t capacity_bytes) {
+	bool directory_changed;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		directory_changed = directory != directory_p && directory_p != failed_directory;
+	}
+	if (directory_changed) {
+		Flush();
+	}
+	string error;
+	vector<string> unlink_paths;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		if (directory != directory_p && directory_p != failed_directory) {
+			enabled = false;
+			entries.clear();
+			lru.clear();
+			evicted_since_flush.clear();
+			size_bytes = 0;
+			access_clock = 0;
+			inserts_since_flush = 0;
+			directory = directory_p;
+			failed_directory.clear();
+#ifdef __linux__
+			auto create_error = directory.empty() ? 0 : CreateDirectories(directory);
+			if (create_error != 0) {
+				error = "cannot create directory '" + directory + "': " + strerror(create_error);
+				failed_directory = directory;
+				directory.clear();
+			} else if (!directory.empty()) {
+				LoadIndexLocked();
+				RemoveOrphansLocked();
+			}
+#else
+			directory.clear();
+#endif
+		}
+		capacity = capacity_bytes;
+		enabled = !directory.empty() && capacity > 0;
+		while (!lru.empty() && size_bytes.load(std::memory_order_relaxed) > capacity) {
+			RemoveLocked(lru.back(), unlink_paths);
+		}
+	}
+#ifdef __linux__
+	for (auto &path : unlink_paths) {
+		unlink(path.c_str());
+	}
+#endif
+	return error;
+}
+
+void S3RedirectDiskCache::LoadIndexLocked() {
+#ifdef __linux__
+	DiskCacheIndexHeader header;
+	vector<DiskCacheIndexRecord> records;
+	if (!ReadIndex(IndexPath(directory), header, records)) {
+		// Unknown or torn index: start empty; RemoveOrphansLocked() then clears the chunk files.
+		return;
+	}
+	// Oldest first, so each push_front leaves the most recently used chunk at the front.
+	std::sort(records.begin(), records.end(), [](const DiskCacheIndexRecord &a, const DiskCacheIndexRecord &b) {
+		return a.last_access < b.last_access;
+	});
+	for (auto &record : records) {
+		ChunkKey key {record.object_hash, record.chunk_index};
+		if (record.size == 0 || record.size > CHUNK_SIZE || entries.find(key) != entries.end()) {
+			continue;
+		}
+		InsertLocked(key, record.size, record.checksum, record.last_access);
+	}
+	access_clock = header.access_clock;
+#endif
+}
+
+void S3RedirectDiskCache::RemoveOrphansLocked() {
+#ifdef __linux__
+	DIR *dir = opendir(directory.c_str());
+	if (!dir) {
+		return;
+	}
+	unordered_set<string> indexed;
+	for (auto &entry : entries) {
+		indexed.insert(ChunkPath(directory, entry.first));
+	}
+	unordered_set<string> present;
+	vector<string> orphans;
+	auto cutoff = time(nullptr) - ORPHAN_MIN_AGE_SECONDS;
+	while (auto dirent = readdir(dir)) {
+		string name(dirent->d_name);
+		if (name == "." || name == ".." || name == INDEX_FILE_NAME) {
+			continue;
+		}
+		auto path = directory + "/" + name;
+		if (indexed.find(path) != indexed.end()) {
+			present.insert(path);
+			continue;
+		}
+		if (name.find(CHUNK_SUFFIX) == string::npos && name.find(TEMP_INFIX) == string::npos) {
+			continue;
+		}
+		// Chunks written after the last index flush, or leftover temp files. Recent ones may be
+		// another process's writes in progress, or its chunks not yet in the index.
+		struct stat st;
+		if (lstat(path.c_str(), &st) == 0 && st.st_mtime < cutoff) {
+			orphans.push_back(path);
+		}
+	}
+	closedir(dir);
+	for (auto &path : orphans) {
+		unlink(path.c_str());
+	}
+	// Index entries whose chunk file has disappeared.
+	vector<ChunkKey> missing;
+	for (auto &entry : entries) {
+		if (present.find(ChunkPath(directory, entry.first)) == present.end()) {
+			missing.push_back(entry.first);
+		}
+	}
+	vector<string> unused;
+	for (auto &key : missing) {
+		RemoveLocked(key, unused);
+	}
+#endif
+}
+
+bool S3RedirectDiskCache::ReadChunk(uint64_t object_hash, idx_t chunk_index, data_ptr_t target, idx_t size) {
+#ifdef __linux__
+	ChunkKey key {object_hash, chunk_index};
+	string path;
+	uint64_t checksum;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		auto it = enabled ? entries.find(key) : entries.end();
+		if (it == entries.end() || it->second.size != size) {
+			misses.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		lru.splice(lru.begin(), lru, it->second.lru_position);
+		it->second.last_access = ++access_clock;
+		checksum = it->second.checksum;
+		path = ChunkPath(directory, key);
+	}
+	// pread outside the lock; a concurrent eviction only turns this into a miss. Chunk files are not
+	// fsync()ed, so one cut short or left with garbage by a crash fails the length or checksum check
+	// and is dropped.
+	if (!ReadFileExact(path, target, size) || ChunkChecksum(target, size) != checksum) {
+		vector<string> unlink_paths;
+		std::lock_guard<std::mutex> lk(lock);
+		RemoveLocked(key, unlink_paths);
+		misses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	hits.fetch_add(1, std::memory_order_relaxed);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void S3RedirectDiskCache::WriteChunk(uint64_t object_hash, idx_t chunk_index, const_data_ptr_t data, idx_t size) {
+#ifdef __linux__
+	ChunkKey key {object_hash, chunk_index};
+	string target_directory;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		if (!enabled || size == 0 || size > CHUNK_SIZE || size > capacity || entries.find(key) != entries.end()) {
+			return;
+		}
+		target_directory = directory;
+	}
+	auto path = ChunkPath(target_directory, key);
+	auto checksum = ChunkChecksum(data, size);
+	if (!WriteFileAtomic(path, TempPath(path), data, size, false)) {
+		return;
+	}
+	vector<string> unlink_paths;
+	bool flush = false;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		if (directory != target_directory) {
+			// Reconfigured while writing; the chunk is an orphan of the old directory.
+			unlink_paths.push_back(path);
+		} else if (entries.find(key) == entries.end()) {
+			InsertLocked(key, uint32_t(size), checksum, ++access_clock);
+			while (size_bytes.load(std::memory_order_relaxed) > capacity) {
+				RemoveLocked(lru.back(), unlink_paths);
+			}
+			flush = ++inserts_since_flush >= INDEX_FLUSH_INTERVAL;
+		}
+	}
+	for (auto &unlink_path : unlink_paths) {
+		unlink(unlink_path.c_str());
+	}
+	if (flush) {
+		Flush();
+	}
+#endif
+}
+
+void S3RedirectDiskCache::Flush() {
+#ifdef __linux__
+	std::lock_guard<std::mutex> flush_guard(flush_lock);
+	string target_directory;
+	DiskCacheIndexHeader header;
+	vector<DiskCacheIndexRecord> records;
+	std::unordered_set<ChunkKey, ChunkKeyHash> evicted;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		if (directory.empty()) {
+			return;
+		}
+		target_directory = directory;
+		memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+		header.chunk_size = CHUNK_SIZE;
+		header.access_clock = access_clock;
+		header.entry_count = entries.size();
+		records.reserve(entries.size());
+		for (auto &entry : entries) {
+			records.push_back(
+			    DiskCacheIndexRecord {entry.first.object_hash, entry.first.chunk_index, entry.second.last_access,
+			                          entry.second.checksum, entry.second.size, 0});
+		}
+		inserts_since_flush = 0;
+		evicted = std::move(evicted_since_flush);
+		evicted_since_flush.clear();
+	}
+	// Other processes sharing the directory may have flushed entries of their own since this one
+	// loaded the index; keep them, except the chunks evicted here (their files are gone). The lock
+	// makes the read-merge-write atomic across processes.
+	auto path = IndexPath(target_directory);
+	auto lock_path = target_directory + "/" + INDEX_LOCK_FILE_NAME;
+	int lock_fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (lock_fd >= 0) {
+		while (flock(lock_fd, LOCK_EX) != 0 && errno == EINTR) {
+		}
+	}
+	DiskCacheIndexHeader disk_header;
+	vector<DiskCacheIndexRecord> disk_records;
+	if (ReadIndex(path, disk_header, disk_records)) {
+		std::unordered_set<ChunkKey, ChunkKeyHash> known;
+		for (auto &record : records) {
+			known.insert(ChunkKey {record.object_hash, record.chunk_index});
+		}
+		for (auto &record : disk_records) {
+			ChunkKey key {record.object_hash, record.chunk_index};
+			if (known.find(key) == known.end() && evicted.find(key) == evicted.end()) {
+				records.push_back(record);
+			}
+		}
+		header.entry_count = records.size();
+	}
+	auto index_size = sizeof(header) + records.size() * sizeof(DiskCacheIndexRecord);
+	auto data = make_unsafe_uniq_array_uninitialized<data_t>(index_size);
+	memcpy(data.get(), &header, sizeof(header));
+	if (!records.empty()) {
+		memcpy(data.get() + sizeof(header), records.data(), records.size() * sizeof(DiskCacheIndexRecord));
+	}
+	WriteFileAtomic(path, TempPath(path), data.get(), index_size, true);
+	if (lock_fd >= 0) {
+		// Closing releases the flock.
+		close(lock_fd);
+	}
+#endif
+}
+
+} // namespace duckdb
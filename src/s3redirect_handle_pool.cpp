@@ -0,0 +1,327 @@
+#include "s3redirect_handle_pool.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+static std::atomic<uint64_t> next_pool_id {1};
+
+thread_local S3RedirectHandlePool::ThreadSlotCache S3RedirectHandlePool::thread_slot_cache;
+
+S3RedirectHandlePool::S3RedirectHandlePool() : pool_id(next_pool_id.fetch_add(1)) {
+}
+
+S3RedirectHandlePool::~S3RedirectHandlePool() {
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		shutdown = true;
+	}
+	reaper_wakeup.notify_all();
+	if (reaper.joinable()) {
+		reaper.join();
+	}
+	Clear();
+}
+
+void S3RedirectHandlePool::SetLimits(idx_t max_per_key_p, idx_t max_total_p, idx_t target_idle_p,
+                                     idx_t idle_timeout_ms) {
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		max_per_key = max_per_key_p;
+		max_total = max_total_p;
+		target_idle = target_idle_p;
+		idle_timeout = std::chrono::milliseconds(idle_timeout_ms);
+		pooling_enabled.store(max_per_key > 0 && max_total > 0, std::memory_order_relaxed);
+	}
+	// A shorter timeout or a lower target should not wait out the reaper's current sleep.
+	reaper_wakeup.notify_all();
+}
+
+void S3RedirectHandlePool::CloseAll(vector<unique_ptr<FileHandle>> &closed) {
+	for (auto &handle : closed) {
+		if (handle) {
+			handle->Close();
+		}
+	}
+	closed.clear();
+}
+
+void S3RedirectHandlePool::ReportIdleChange(int64_t idle_delta) {
+	if (idle_delta != 0) {
+		idle_handles.fetch_add(idle_delta, std::memory_order_relaxed);
+	}
+}
+
+S3RedirectHandlePool::ThreadSlot &S3RedirectHandlePool::GetThreadSlot() {
+	auto &cache = thread_slot_cache;
+	if (cache.pool_id == pool_id) {
+		return *cache.slot;
+	}
+	auto slot = make_shared_ptr<ThreadSlot>();
+	bool start_reaper = false;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		thread_slots.push_back(slot);
+		start_reaper = !reaper.joinable() && !shutdown;
+		if (start_reaper) {
+			reaper = std::thread([this]() { ReaperLoop(); });
+		}
+	}
+	if (!start_reaper) {
+		reaper_wakeup.notify_all();
+	}
+	cache.pool_id = pool_id;
+	cache.slot = slot;
+	return *slot;
+}
+
+void S3RedirectHandlePool::RemoveLocked(lru_iterator position, vector<unique_ptr<FileHandle>> &closed) {
+	auto entry = by_key.find(position->key);
+	D_ASSERT(entry != by_key.end());
+	auto &positions = entry->second;
+	positions.erase(std::find(positions.begin(), positions.end(), position));
+	if (positions.empty()) {
+		by_key.erase(entry);
+	}
+	closed.push_back(std::move(position->handle));
+	lru.erase(position);
+}
+
+void S3RedirectHandlePool::ReapLocked(pool_clock_t::time_point now, vector<unique_ptr<FileHandle>> &closed) {
+	while (!lru.empty() && now - lru.back().idle_since > idle_timeout) {
+		RemoveLocked(std::prev(lru.end()), closed);
+		reaped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void S3RedirectHandlePool::ReapSlotsLocked(pool_clock_t::time_point now, vector<unique_ptr<FileHandle>> &closed,
+                                           idx_t &emptied_slots) {
+	for (idx_t i = 0; i < thread_slots.size();) {
+		auto &slot = *thread_slots[i];
+		// Only our registry still references the slot: its thread exited or moved to another pool.
+		bool abandoned = thread_slots[i].use_count() == 1;
+		unique_ptr<IdleHandle> idle(slot.idle.exchange(nullptr, std::memory_order_acquire));
+		if (idle && !abandoned && now - idle->idle_since <= idle_timeout) {
+			IdleHandle *expected = nullptr;
+			if (slot.idle.compare_exchange_strong(expected, idle.get(), std::memory_order_release)) {
+				idle.release();
+			} else {
+				// The owner parked another handle meanwhile; keep this one in the shared LRU.
+				InsertLocked(std::move(*idle), closed);
+				emptied_slots++;
+			}
+		} else if (idle) {
+			closed.push_back(std::move(idle->handle));
+			reaped.fetch_add(1, std::memory_order_relaxed);
+			emptied_slots++;
+		}
+		if (abandoned) {
+			hits.fetch_add(slot.hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			thread_slots[i] = std::move(thread_slots.back());
+			thread_slots.pop_back();
+		} else {
+			i++;
+		}
+	}
+}
+
+S3RedirectHandlePool::pool_clock_t::duration S3RedirectHandlePool::ReapIntervalLocked() const {
+	pool_clock_t::duration interval = idle_timeout / 4;
+	return std::max<pool_clock_t::duration>(std::min<pool_clock_t::duration>(interval, std::chrono::seconds(5)),
+	                                        std::chrono::milliseconds(100));
+}
+
+void S3RedirectHandlePool::ReaperLoop() {
+	std::unique_lock<std::mutex> lk(lock);
+	while (!shutdown) {
+		if (lru.empty() && thread_slots.empty()) {
+			reaper_wakeup.wait(lk, [this]() { return shutdown || !lru.empty() || !thread_slots.empty(); });
+			continue;
+		}
+		auto interval = ReapIntervalLocked();
+		reaper_wakeup.wait_for(lk, interval);
+		if (shutdown) {
+			break;
+		}
+		vector<unique_ptr<FileHandle>> closed;
+		auto now = pool_clock_t::now();
+		auto idle_before = int64_t(lru.size());
+		idx_t emptied_slots = 0;
+		ReapSlotsLocked(now, closed, emptied_slots);
+		ReapLocked(now, closed);
+		// Shrink back to the target, coldest first, sparing handles returned since the last pass.
+		while (lru.size() > target_idle && now - lru.back().idle_since >= interval) {
+			RemoveLocked(std::prev(lru.end()), closed);
+			reaped.fetch_add(1, std::memory_order_relaxed);
+		}
+		auto idle_delta = int64_t(lru.size()) - idle_before - int64_t(emptied_slots);
+		if (closed.empty() && idle_delta == 0) {
+			continue;
+		}
+		// Closing may block on the network; never hold the lock across it.
+		lk.unlock();
+		CloseAll(closed);
+		ReportIdleChange(idle_delta);
+		lk.lock();
+	}
+}
+
+unique_ptr<FileHandle> S3RedirectHandlePool::Acquire(const string &key) {
+	auto &slot = GetThreadSlot();
+	unique_ptr<IdleHandle> parked(slot.idle.exchange(nullptr, std::memory_order_acquire));
+	if (parked) {
+		ReportIdleChange(-1);
+	}
+	if (parked && parked->key == key) {
+		slot.hits.store(slot.hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return std::move(parked->handle);
+	}
+	if (parked) {
+		// Another object's handle: share it rather than keep it parked where this thread no
+		// longer looks.
+		ReleaseShared(std::move(parked));
+	}
+	vector<unique_ptr<FileHandle>> closed;
+	unique_ptr<FileHandle> result;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		ReapLocked(pool_clock_t::now(), closed);
+		auto entry = by_key.find(key);
+		if (entry != by_key.end()) {
+			auto position = entry->second.back();
+			result = std::move(position->handle);
+			entry->second.pop_back();
+			if (entry->second.empty()) {
+				by_key.erase(entry);
+			}
+			lru.erase(position);
+		}
+	}
+	ReportIdleChange(-int64_t(closed.size() + (result ? 1 : 0)));
+	CloseAll(closed);
+	if (result) {
+		hits.fetch_add(1, std::memory_order_relaxed);
+	} else {
+		misses.fetch_add(1, std::memory_order_relaxed);
+	}
+	return result;
+}
+
+void S3RedirectHandlePool::InsertLocked(IdleHandle idle, vector<unique_ptr<FileHandle>> &closed) {
+	if (max_per_key == 0 || max_total == 0 || shutdown) {
+		closed.push_back(std::move(idle.handle));
+		return;
+	}
+	auto existing = by_key.find(idle.key);
+	if (existing != by_key.end() && existing->second.size() >= max_per_key) {
+		// Per-key cap: drop the coldest handle for this object.
+		RemoveLocked(existing->second.front(), closed);
+	}
+	while (lru.size() >= max_total) {
+		RemoveLocked(std::prev(lru.end()), closed);
+	}
+	// Keep the LRU ordered by idle time: a handle displaced from a slot may be older than the
+	// front.
+	auto position = lru.begin();
+	while (position != lru.end() && position->idle_since > idle.idle_since) {
+		position++;
+	}
+	auto key = idle.key;
+	auto inserted = lru.insert(position, std::move(idle));
+	// by_key stays oldest first, so the warmest handle is at the back.
+	auto &positions = by_key[key];
+	auto slot = positions.begin();
+	while (slot != positions.end() && (*slot)->idle_since <= inserted->idle_since) {
+		slot++;
+	}
+	positions.insert(slot, inserted);
+}
+
+void S3RedirectHandlePool::ReleaseShared(unique_ptr<IdleHandle> idle) {
+	vector<unique_ptr<FileHandle>> closed;
+	int64_t idle_before;
+	int64_t idle_delta;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		idle_before = int64_t(lru.size());
+		ReapLocked(pool_clock_t::now(), closed);
+		InsertLocked(std::move(*idle), closed);
+		idle_delta = int64_t(lru.size()) - idle_before;
+	}
+	if (idle_before == 0) {
+		// The reaper only sleeps without a timeout while the pool is empty; otherwise it is already
+		// on its reap interval and a wakeup per return would just be a futex call on a hot path.
+		reaper_wakeup.notify_all();
+	}
+	ReportIdleChange(idle_delta);
+	CloseAll(closed);
+}
+
+void S3RedirectHandlePool::Release(const string &key, unique_ptr<FileHandle> handle) {
+	if (!pooling_enabled.load(std::memory_order_relaxed)) {
+		handle->Close();
+		return;
+	}
+	auto &slot = GetThreadSlot();
+	auto idle = new IdleHandle {key, std::move(handle), pool_clock_t::now()};
+	unique_ptr<IdleHandle> displaced(slot.idle.exchange(idle, std::memory_order_acq_rel));
+	if (displaced) {
+		// The slot stays occupied; ReleaseShared counts the displaced handle if the LRU keeps it.
+		ReleaseShared(std::move(displaced));
+	} else {
+		ReportIdleChange(1);
+	}
+}
+
+idx_t S3RedirectHandlePool::ReapIdle() {
+	vector<unique_ptr<FileHandle>> closed;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		ReapLocked(pool_clock_t::now(), closed);
+	}
+	auto count = closed.size();
+	ReportIdleChange(-int64_t(count));
+	CloseAll(closed);
+	return count;
+}
+
+void S3RedirectHandlePool::Clear() {
+	vector<unique_ptr<FileHandle>> closed;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		for (auto &idle : lru) {
+			closed.push_back(std::move(idle.handle));
+		}
+		lru.clear();
+		by_key.clear();
+		// Slots stay registered: their threads keep parking handles in them.
+		for (auto &slot : thread_slots) {
+			unique_ptr<IdleHandle> parked(slot->idle.exchange(nullptr, std::memory_order_acquire));
+			if (parked) {
+				closed.push_back(std::move(parked->handle));
+			}
+		}
+	}
+	ReportIdleChange(-int64_t(closed.size()));
+	CloseAll(closed);
+}
+
+idx_t S3RedirectHandlePool::GetIdleCount() {
+	std::lock_guard<std::mutex> lk(lock);
+	idx_t count = lru.size();
+	for (auto &slot : thread_slots) {
+		count += slot->idle.load(std::memory_order_relaxed) ? 1 : 0;
+	}
+	return count;
+}
+
+idx_t S3RedirectHandlePool::GetHits() {
+	std::lock_guard<std::mutex> lk(lock);
+	idx_t total = hits.load(std::memory_order_relaxed);
+	for (auto &slot : thread_slots) {
+		total += slot->hits.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+} // namespace duckdb
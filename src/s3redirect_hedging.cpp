@@ -0,0 +1,103 @@
+#include "s3redirect_hedging.hpp"
+
+namespace duckdb {
+
+// Bucket 4*e + m holds latencies in [(4 + m) << (e - 2), (5 + m) << (e - 2)) for e >= 2, where e
+// is the position of the highest set bit; latencies below 4us share the first buckets.
+idx_t S3RedirectEndpointLatency::BucketIndex(idx_t micros) {
+	if (micros < 4) {
+		return micros;
+	}
+	idx_t msb = 63 - idx_t(__builtin_clzll(micros));
+	idx_t mantissa = (micros >> (msb - 2)) & 3;
+	return MinValue<idx_t>(msb * 4 + mantissa, BUCKET_COUNT - 1);
+}
+
+idx_t S3RedirectEndpointLatency::BucketUpperBound(idx_t index) {
+	if (index < 8) {
+		return index + 1;
+	}
+	idx_t msb = index / 4;
+	idx_t mantissa = index % 4;
+	return (5 + mantissa) << (msb - 2);
+}
+
+void S3RedirectEndpointLatency::Record(idx_t micros) {
+	std::lock_guard<std::mutex> lk(lock);
+	buckets[BucketIndex(micros)]++;
+	samples++;
+	if (++since_decay >= DECAY_SAMPLES) {
+		samples = 0;
+		for (auto &bucket : buckets) {
+			bucket /= 2;
+			samples += bucket;
+		}
+		since_decay = 0;
+	}
+}
+
+idx_t S3RedirectEndpointLatency::Percentile(idx_t percentile) const {
+	std::lock_guard<std::mutex> lk(lock);
+	if (samples < MIN_SAMPLES) {
+		return 0;
+	}
+	auto target = (samples * MinValue<idx_t>(percentile, 100) + 99) / 100;
+	idx_t seen = 0;
+	for (idx_t i = 0; i < BUCKET_COUNT; i++) {
+		seen += buckets[i];
+		if (seen >= target) {
+			return BucketUpperBound(i);
+		}
+	}
+	return BucketUpperBound(BUCKET_COUNT - 1);
+}
+
+bool S3RedirectEndpointLatency::TryStartHedge(idx_t max_ratio_percent) {
+	auto budget = requests.load(std::memory_order_relaxed) * max_ratio_percent / 100 + 1;
+	auto current = hedges.load(std::memory_order_relaxed);
+	do {
+		if (current >= budget) {
+			return false;
+		}
+	} while (!hedges.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+	return true;
+}
+
+void S3RedirectHedging::Configure(bool enabled_p, idx_t percentile_p, idx_t max_ratio_percent_p,
+                                  idx_t min_delay_ms_p) {
+	percentile.store(MinValue<idx_t>(percentile_p, 100), std::memory_order_relaxed);
+	max_ratio_percent.store(max_ratio_percent_p, std::memory_order_relaxed);
+	min_delay_us.store(min_delay_ms_p * 1000, std::memory_order_relaxed);
+	enabled.store(enabled_p, std::memory_order_relaxed);
+}
+
+S3RedirectEndpointLatency &S3RedirectHedging::GetEndpoint(const string &s3_url) {
+	// "s3://bucket/key" -> "s3://bucket": requests to one bucket share a latency profile.
+	auto authority = s3_url.find("://");
+	auto path = s3_url.find('/', authority == string::npos ? 0 : authority + 3);
+	auto endpoint = s3_url.substr(0, path);
+	std::lock_guard<std::mutex> lk(endpoints_lock);
+	auto &entry = endpoints[endpoint];
+	if (!entry) {
+		entry = make_uniq<S3RedirectEndpointLatency>();
+	}
+	return *entry;
+}
+
+idx_t S3RedirectHedging::GetDeadline(const S3RedirectEndpointLatency &endpoint) const {
+	auto latency = endpoint.Percentile(percentile.load(std::memory_order_relaxed));
+	if (latency == 0) {
+		return 0;
+	}
+	return MaxValue<idx_t>(latency, min_delay_us.load(std::memory_order_relaxed));
+}
+
+bool S3RedirectHedging::TryStartHedge(S3RedirectEndpointLatency &endpoint) {
+	if (!endpoint.TryStartHedge(max_ratio_percent.load(std::memory_order_relaxed))) {
+		return false;
+	}
+	hedges_sent.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+} // namespace duckdb
@@ -0,0 +1,178 @@
+#include "s3redirect_io_scheduler.hpp"
+
+#include "duckdb/common/string_util.hpp"
+
+namespace duckdb {
+
+void S3RedirectIOScheduler::Configure(idx_t max_in_flight_p, idx_t max_in_flight_per_endpoint_p) {
+	// A per-endpoint cap of 0 means "only the global cap".
+	auto per_endpoint = max_in_flight_per_endpoint_p == 0
+	                        ? max_in_flight_p
+	                        : MinValue<idx_t>(max_in_flight_per_endpoint_p, max_in_flight_p);
+	std::lock_guard<std::mutex> lk(lock);
+	max_in_flight.store(max_in_flight_p, std::memory_order_relaxed);
+	max_in_flight_per_endpoint.store(per_endpoint, std::memory_order_relaxed);
+	if (max_in_flight_p > 0) {
+		// A raised cap may admit queued reads right away.
+		DispatchLocked();
+		return;
+	}
+	// Disabled while reads were queued: let them all go without taking a slot.
+	for (auto &entry : queues) {
+		for (auto waiter : entry.second) {
+			waiter->granted = true;
+			waiter->granted_signal.notify_one();
+		}
+	}
+	queues.clear();
+	client_order.clear();
+	queue_depth.store(0, std::memory_order_relaxed);
+}
+
+S3RedirectIOScheduler::Endpoint &S3RedirectIOScheduler::GetEndpoint(const string &s3_url) {
+	// "s3://bucket/key" -> "s3://bucket"
+	auto authority = s3_url.find("://");
+	auto path = s3_url.find('/', authority == string::npos ? 0 : authority + 3);
+	auto name = s3_url.substr(0, path);
+	std::lock_guard<std::mutex> lk(lock);
+	auto &entry = endpoints[name];
+	if (!entry) {
+		entry = make_uniq<Endpoint>();
+	}
+	return *entry;
+}
+
+// True when a status right after `prefix` somewhere in `message` is 429 or 503.
+static bool HasThrottlingStatus(const string &message, const string &prefix) {
+	for (auto pos = message.find(prefix); pos != string::npos; pos = message.find(prefix, pos + 1)) {
+		auto start = pos + prefix.size();
+		auto end = start;
+		while (end < message.size() && message[end] >= '0' && message[end] <= '9') {
+			end++;
+		}
+		auto status = message.substr(start, end - start);
+		if (status == "429" || status == "503") {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool S3RedirectIOScheduler::IsThrottlingError(const string &message) {
+	// httpfs words the status as "(HTTP 503 ...)", and an HTTPException also carries it as the
+	// status_code of its JSON-encoded message. Digits elsewhere (in the URL or the range) say
+	// nothing about the response.
+	return HasThrottlingStatus(message, "HTTP ") || HasThrottlingStatus(message, "\"status_code\":\"") ||
+	       StringUtil::Contains(message, "SlowDown");
+}
+
+double S3RedirectIOScheduler::EffectiveLimitLocked(const Endpoint &endpoint) const {
+	auto cap = double(MaxValue<idx_t>(max_in_flight_per_endpoint.load(std::memory_order_relaxed), 1));
+	auto limit = endpoint.limit.load(std::memory_order_relaxed);
+	// 0: never throttled, so the endpoint runs at the configured cap.
+	return limit == 0 ? cap : MinValue<double>(limit, cap);
+}
+
+bool S3RedirectIOScheduler::HasCapacityLocked(const Endpoint &endpoint) const {
+	if (global_in_flight >= max_in_flight.load(std::memory_order_relaxed)) {
+		return false;
+	}
+	return endpoint.in_flight < MaxValue<idx_t>(idx_t(EffectiveLimitLocked(endpoint)), 1);
+}
+
+void S3RedirectIOScheduler::GrantLocked(Endpoint &endpoint) {
+	global_in_flight++;
+	endpoint.in_flight++;
+	global_in_flight_metric.store(global_in_flight, std::memory_order_relaxed);
+}
+
+void S3RedirectIOScheduler::DispatchLocked() {
+	// Each pass offers one slot to every waiting client in turn; a client whose queued reads all
+	// target saturated endpoints is skipped without losing its place.
+	bool progress = true;
+	while (progress && !client_order.empty()) {
+		progress = false;
+		auto clients = client_order.size();
+		for (idx_t i = 0; i < clients && !client_order.empty(); i++) {
+			auto client = client_order.front();
+			client_order.pop_front();
+			auto &queue = queues[client];
+			for (auto it = queue.begin(); it != queue.end(); ++it) {
+				auto waiter = *it;
+				if (!HasCapacityLocked(*waiter->endpoint)) {
+					continue;
+				}
+				GrantLocked(*waiter->endpoint);
+				waiter->slot_taken = true;
+				waiter->granted = true;
+				waiter->granted_signal.notify_one();
+				queue.erase(it);
+				queue_depth.fetch_sub(1, std::memory_order_relaxed);
+				progress = true;
+				break;
+			}
+			if (queue.empty()) {
+				queues.erase(client);
+			} else {
+				client_order.push_back(client);
+			}
+		}
+	}
+}
+
+S3RedirectIOScheduler::Slot S3RedirectIOScheduler::Acquire(Endpoint &endpoint, uintptr_t client) {
+	if (!Enabled()) {
+		return Slot();
+	}
+	std::unique_lock<std::mutex> lk(lock);
+	if (!Enabled()) {
+		return Slot();
+	}
+	if (client_order.empty() && HasCapacityLocked(endpoint)) {
+		GrantLocked(endpoint);
+		return Slot(*this, endpoint);
+	}
+	Waiter waiter;
+	waiter.endpoint = &endpoint;
+	auto &queue = queues[client];
+	if (queue.empty()) {
+		client_order.push_back(client);
+	}
+	queue.push_back(&waiter);
+	queue_depth.fetch_add(1, std::memory_order_relaxed);
+	queued_requests.fetch_add(1, std::memory_order_relaxed);
+	DispatchLocked();
+
+	auto start = std::chrono::steady_clock::now();
+	waiter.granted_signal.wait(lk, [&waiter]() { return waiter.granted; });
+	auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	wait_micros.fetch_add(waited.count(), std::memory_order_relaxed);
+	if (!waiter.slot_taken) {
+		// Released by Configure disabling the scheduler.
+		return Slot();
+	}
+	return Slot(*this, endpoint);
+}
+
+void S3RedirectIOScheduler::Release(Endpoint &endpoint, bool throttled) {
+	std::lock_guard<std::mutex> lk(lock);
+	global_in_flight--;
+	endpoint.in_flight--;
+	global_in_flight_metric.store(global_in_flight, std::memory_order_relaxed);
+	auto cap = double(MaxValue<idx_t>(max_in_flight_per_endpoint.load(std::memory_order_relaxed), 1));
+	auto limit = EffectiveLimitLocked(endpoint);
+	if (throttled) {
+		auto now = std::chrono::steady_clock::now();
+		if (now - endpoint.last_decrease >= THROTTLE_COOLDOWN) {
+			limit = MaxValue<double>(limit / 2, 1);
+			endpoint.last_decrease = now;
+			throttle_events.fetch_add(1, std::memory_order_relaxed);
+		}
+	} else {
+		limit = MinValue<double>(limit + 1 / limit, cap);
+	}
+	endpoint.limit.store(limit, std::memory_order_relaxed);
+	DispatchLocked();
+}
+
+} // namespace duckdb
@@ -0,0 +1,144 @@
+#include "s3redirect_mount_table.hpp"
+
+#include "duckdb/common/string_util.hpp"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+namespace duckdb {
+
+static constexpr const char *MOUNTS_PATH = "/proc/self/mounts";
+
+// Mount points and sources in the table escape space, tab, newline and backslash as \ooo.
+static string DecodeMountField(const string &field) {
+	string result;
+	for (idx_t i = 0; i < field.size(); i++) {
+		if (field[i] == '\\' && i + 3 < field.size() && field[i + 1] >= '0' && field[i + 1] <= '3') {
+			result += char((field[i + 1] - '0') * 64 + (field[i + 2] - '0') * 8 + (field[i + 3] - '0'));
+			i += 3;
+		} else {
+			result += field[i];
+		}
+	}
+	return result;
+}
+
+static std::atomic<uint64_t> next_table_id {1};
+
+thread_local S3RedirectMountTable::SnapshotCache S3RedirectMountTable::snapshot_cache;
+
+// `path` made absolute against `cwd`, without trailing slashes (except for "/" itself).
+static string AbsolutePath(const string &path, const string &cwd) {
+	auto absolute = StringUtil::StartsWith(path, "/") ? path : cwd + "/" + path;
+	while (absolute.size() > 1 && absolute.back() == '/') {
+		absolute.pop_back();
+	}
+	return absolute;
+}
+
+S3RedirectMountTable::S3RedirectMountTable()
+    : table_id(next_table_id.fetch_add(1)), filesystem_type(DEFAULT_FILESYSTEM_TYPE) {
+}
+
+void S3RedirectMountTable::Configure(const string &filesystem_type_p, const vector<string> &extra_paths_p) {
+	std::lock_guard<std::mutex> lk(lock);
+	auto type = StringUtil::Lower(filesystem_type_p);
+	if (type == filesystem_type && extra_paths_p == extra_paths) {
+		return;
+	}
+	filesystem_type = std::move(type);
+	extra_paths = extra_paths_p;
+	next_load_us.store(0, std::memory_order_release);
+}
+
+shared_ptr<const S3RedirectMountTable::Snapshot> S3RedirectMountTable::Load(const string &filesystem_type,
+                                                                            const vector<string> &extra_paths) {
+	auto result = make_shared_ptr<Snapshot>();
+#ifdef __linux__
+	char cwd[4096];
+	if (getcwd(cwd, sizeof(cwd))) {
+		result->cwd = cwd;
+	}
+	auto &mounts = result->mounts;
+	std::ifstream table(MOUNTS_PATH);
+	string line;
+	while (std::getline(table, line)) {
+		// "source mount_point type options dump pass"
+		std::istringstream fields(line);
+		string source, mount_point, type;
+		if (!(fields >> source >> mount_point >> type)) {
+			continue;
+		}
+		Mount mount;
+		mount.mount_point = DecodeMountField(mount_point);
+		mount.cwiqfs = !filesystem_type.empty() && StringUtil::Lower(type) == filesystem_type;
+		mounts.push_back(std::move(mount));
+	}
+	// Configured directories act as mounts layered on top of the real ones.
+	for (auto &path : extra_paths) {
+		if (!path.empty() && (StringUtil::StartsWith(path, "/") || !result->cwd.empty())) {
+			mounts.push_back(Mount {AbsolutePath(path, result->cwd), true});
+		}
+	}
+	// Longest first, so the first prefix match is the innermost mount. Among mounts on the same
+	// point the later one shadows the earlier, hence the reverse before the stable sort.
+	std::reverse(mounts.begin(), mounts.end());
+	std::stable_sort(mounts.begin(), mounts.end(), [](const Mount &a, const Mount &b) {
+		return a.mount_point.size() > b.mount_point.size();
+	});
+#endif
+	return result;
+}
+
+static int64_t MonotonicMicros() {
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return int64_t(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+const S3RedirectMountTable::Snapshot &S3RedirectMountTable::GetSnapshot() {
+	auto now = MonotonicMicros();
+	if (now >= next_load_us.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lk(lock);
+		if (now >= next_load_us.load(std::memory_order_relaxed)) {
+			snapshot = Load(filesystem_type, extra_paths);
+			next_load_us.store(now + RELOAD_INTERVAL_US, std::memory_order_relaxed);
+			generation.fetch_add(1, std::memory_order_release);
+		}
+	}
+	auto &cache = snapshot_cache;
+	if (cache.table_id != table_id || cache.generation != generation.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lk(lock);
+		cache.table_id = table_id;
+		cache.generation = generation.load(std::memory_order_relaxed);
+		cache.snapshot = snapshot;
+	}
+	return *cache.snapshot;
+}
+
+bool S3RedirectMountTable::IsCwiqfsPath(const string &path) {
+#ifdef __linux__
+	auto &current = GetSnapshot();
+	if (!StringUtil::StartsWith(path, "/") && current.cwd.empty()) {
+		return false;
+	}
+	auto absolute = StringUtil::StartsWith(path, "/") ? path : current.cwd + "/" + path;
+	for (auto &mount : current.mounts) {
+		auto &point = mount.mount_point;
+		bool inside = point == "/" || (StringUtil::StartsWith(absolute, point) &&
+		                               (absolute.size() == point.size() || absolute[point.size()] == '/'));
+		if (inside) {
+			return mount.cwiqfs;
+		}
+	}
+#endif
+	return false;
+}
+
+} // namespace duckdb
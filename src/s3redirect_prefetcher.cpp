@@ -0,0 +1,108 @@
+#include "s3redirect_prefetcher.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+S3RedirectPrefetcher::S3RedirectPrefetcher(S3RedirectTaskPool &task_pool_p, fetch_function_t fetch_p, idx_t budget_p)
+    : task_pool(task_pool_p), fetch(std::move(fetch_p)), budget(budget_p) {
+}
+
+S3RedirectPrefetcher::~S3RedirectPrefetcher() {
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		for (auto &range : ranges) {
+			std::lock_guard<std::mutex> range_lk(range->lock);
+			if (range->state == RangeState::PENDING) {
+				range->state = RangeState::CANCELLED;
+			}
+		}
+	}
+	std::unique_lock<std::mutex> lk(in_flight_lock);
+	in_flight_done.wait(lk, [this]() { return in_flight == 0; });
+}
+
+void S3RedirectPrefetcher::RunRange(Range &range) {
+	{
+		std::lock_guard<std::mutex> lk(range.lock);
+		if (range.state != RangeState::PENDING) {
+			return;
+		}
+		range.state = RangeState::RUNNING;
+	}
+	std::exception_ptr error;
+	try {
+		fetch(range.data.get(), range.length, range.offset);
+	} catch (...) {
+		error = std::current_exception();
+	}
+	{
+		std::lock_guard<std::mutex> lk(range.lock);
+		range.error = error;
+		range.state = RangeState::DONE;
+	}
+	range.done.notify_all();
+}
+
+void S3RedirectPrefetcher::Prefetch(idx_t offset, idx_t length) {
+	if (length == 0) {
+		return;
+	}
+	auto range = make_shared_ptr<Range>();
+	range->offset = offset;
+	range->length = length;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		for (auto &existing : ranges) {
+			if (existing->offset <= offset && offset + length <= existing->offset + existing->length) {
+				// Already covered.
+				return;
+			}
+		}
+		if (reserved_bytes + length > budget) {
+			return;
+		}
+		reserved_bytes += length;
+		range->data = make_unsafe_uniq_array_uninitialized<data_t>(length);
+		ranges.push_back(range);
+	}
+	{
+		std::lock_guard<std::mutex> lk(in_flight_lock);
+		in_flight++;
+	}
+	task_pool.Schedule([this, range]() {
+		RunRange(*range);
+		// Notify under the lock: the destructor may free this object as soon as it sees zero.
+		std::lock_guard<std::mutex> lk(in_flight_lock);
+		in_flight--;
+		in_flight_done.notify_all();
+	});
+}
+
+bool S3RedirectPrefetcher::TryRead(data_ptr_t buffer, idx_t nr_bytes, idx_t location) {
+	shared_ptr<Range> range;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		for (auto &candidate : ranges) {
+			if (candidate->offset <= location && location + nr_bytes <= candidate->offset + candidate->length) {
+				range = candidate;
+				break;
+			}
+		}
+	}
+	if (!range) {
+		return false;
+	}
+	// Not picked up by a worker yet: fetch it on this thread rather than queue behind others.
+	RunRange(*range);
+	std::unique_lock<std::mutex> lk(range->lock);
+	range->done.wait(lk, [&range]() { return range->state == RangeState::DONE; });
+	if (range->error) {
+		return false;
+	}
+	lk.unlock();
+	memcpy(buffer, range->data.get() + (location - range->offset), nr_bytes);
+	return true;
+}
+
+} // namespace duckdb
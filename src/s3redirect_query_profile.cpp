@@ -0,0 +1,115 @@
+#include "s3redirect_query_profile.hpp"
+
+#include "duckdb/common/file_opener.hpp"
+#include "duckdb/main/client_context.hpp"
+
+#include <cmath>
+#include <iomanip>
+
+namespace duckdb {
+
+void S3RedirectFileProfile::Reset() {
+	reads.store(0, std::memory_order_relaxed);
+	bytes_read.store(0, std::memory_order_relaxed);
+	requests.store(0, std::memory_order_relaxed);
+	request_bytes.store(0, std::memory_order_relaxed);
+	request_micros.store(0, std::memory_order_relaxed);
+	queue_wait_micros.store(0, std::memory_order_relaxed);
+	cache_hits.store(0, std::memory_order_relaxed);
+	cache_misses.store(0, std::memory_order_relaxed);
+	local_bytes.store(0, std::memory_order_relaxed);
+}
+
+double S3RedirectFileProfileRow::CacheHitRatio() const {
+	auto lookups = cache_hits + cache_misses;
+	return lookups == 0 ? NAN : double(cache_hits) / double(lookups);
+}
+
+shared_ptr<S3RedirectQueryProfile> S3RedirectQueryProfile::Get(optional_ptr<FileOpener> opener) {
+	auto context = FileOpener::TryGetClientContext(opener);
+	if (!context) {
+		return nullptr;
+	}
+	return context->registered_state->GetOrCreate<S3RedirectQueryProfile>(STATE_KEY);
+}
+
+shared_ptr<S3RedirectFileProfile> S3RedirectQueryProfile::GetFile(const string &path) {
+	std::lock_guard<std::mutex> lk(lock);
+	auto &entry = files[path];
+	if (!entry) {
+		entry = make_shared_ptr<S3RedirectFileProfile>();
+	}
+	return entry;
+}
+
+vector<S3RedirectFileProfileRow> S3RedirectQueryProfile::SnapshotLocked() {
+	vector<S3RedirectFileProfileRow> rows;
+	for (auto &entry : files) {
+		auto &file = *entry.second;
+		S3RedirectFileProfileRow row {entry.first,
+		                              file.reads.load(std::memory_order_relaxed),
+		                              file.bytes_read.load(std::memory_order_relaxed),
+		                              file.requests.load(std::memory_order_relaxed),
+		                              file.request_bytes.load(std::memory_order_relaxed),
+		                              file.request_micros.load(std::memory_order_relaxed),
+		                              file.queue_wait_micros.load(std::memory_order_relaxed),
+		                              file.cache_hits.load(std::memory_order_relaxed),
+		                              file.cache_misses.load(std::memory_order_relaxed),
+		                              file.local_bytes.load(std::memory_order_relaxed)};
+		if (row.reads > 0 || row.requests > 0) {
+			rows.push_back(std::move(row));
+		}
+	}
+	return rows;
+}
+
+vector<S3RedirectFileProfileRow> S3RedirectQueryProfile::GetLastQuery() {
+	std::lock_guard<std::mutex> lk(lock);
+	return last_query;
+}
+
+void S3RedirectQueryProfile::QueryBegin(ClientContext &context) {
+	std::lock_guard<std::mutex> lk(lock);
+	for (auto it = files.begin(); it != files.end();) {
+		if (it->second.use_count() == 1) {
+			// No open handle left on this path.
+			it = files.erase(it);
+		} else {
+			it->second->Reset();
+			++it;
+		}
+	}
+}
+
+void S3RedirectQueryProfile::QueryEnd(ClientContext &context) {
+	std::lock_guard<std::mutex> lk(lock);
+	last_query = SnapshotLocked();
+}
+
+void S3RedirectQueryProfile::WriteProfilingInformation(std::ostream &ss) {
+	vector<S3RedirectFileProfileRow> rows;
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		rows = SnapshotLocked();
+	}
+	if (rows.empty()) {
+		return;
+	}
+	ss << "cwiqduck I/O (per redirected file)\n";
+	for (auto &row : rows) {
+		ss << row.path << "\n";
+		ss << "  reads: " << row.reads << ", bytes: " << row.bytes_read << ", local bytes: " << row.local_bytes
+		   << "\n";
+		ss << "  GETs: " << row.requests << ", GET bytes: " << row.request_bytes << std::fixed
+		   << std::setprecision(2) << ", GET time: " << double(row.request_micros) / 1000.0
+		   << " ms, queue wait: " << double(row.queue_wait_micros) / 1000.0 << " ms\n";
+		auto ratio = row.CacheHitRatio();
+		ss << "  cache hits: " << row.cache_hits << ", misses: " << row.cache_misses;
+		if (!std::isnan(ratio)) {
+			ss << ", hit ratio: " << ratio;
+		}
+		ss << "\n";
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,103 @@
+#include "s3redirect_read_coalescer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace duckdb {
+
+S3RedirectReadCoalescer::S3RedirectReadCoalescer(fetch_function_t fetch_p, std::chrono::microseconds window_p,
+                                                 idx_t max_gap_p, idx_t max_span_p)
+    : fetch(std::move(fetch_p)), window(window_p), max_gap(max_gap_p), max_span(max_span_p) {
+}
+
+void S3RedirectReadCoalescer::PlanLocked(Batch &batch) {
+	auto reads = batch.reads;
+	std::sort(reads.begin(), reads.end(),
+	          [](const PendingRead *a, const PendingRead *b) { return a->location < b->location; });
+	shared_ptr<Group> group;
+	for (auto read : reads) {
+		auto read_end = read->location + read->nr_bytes;
+		bool joins = group && read->location <= group->end + max_gap &&
+		             MaxValue<idx_t>(group->end, read_end) - group->start <= max_span;
+		if (!joins) {
+			group = make_shared_ptr<Group>();
+			group->start = read->location;
+			group->end = read_end;
+		}
+		group->end = MaxValue<idx_t>(group->end, read_end);
+		group->members.push_back(read);
+		read->group = group;
+	}
+	batch.planned = true;
+}
+
+void S3RedirectReadCoalescer::ExecuteGroup(Group &group) {
+	if (group.members.size() == 1) {
+		auto read = group.members[0];
+		fetch(read->buffer, read->nr_bytes, read->location);
+		return;
+	}
+	auto span = group.end - group.start;
+	auto data = make_unsafe_uniq_array_uninitialized<data_t>(span);
+	fetch(data.get(), span, group.start);
+	for (auto read : group.members) {
+		memcpy(read->buffer, data.get() + (read->location - group.start), read->nr_bytes);
+	}
+	merged_reads.fetch_add(group.members.size() - 1, std::memory_order_relaxed);
+}
+
+void S3RedirectReadCoalescer::Read(data_ptr_t buffer, idx_t nr_bytes, idx_t location) {
+	PendingRead self;
+	self.buffer = buffer;
+	self.nr_bytes = nr_bytes;
+	self.location = location;
+
+	std::unique_lock<std::mutex> lk(lock);
+	active_reads++;
+	auto batch = open_batch;
+	if (batch) {
+		batch->reads.push_back(&self);
+		changed.wait(lk, [&batch]() { return batch->planned; });
+	} else {
+		// First read of a batch: collect company only if the handle is already busy.
+		batch = make_shared_ptr<Batch>();
+		batch->reads.push_back(&self);
+		open_batch = batch;
+		if (active_reads > 1 && window.count() > 0) {
+			lk.unlock();
+			std::this_thread::sleep_for(window);
+			lk.lock();
+		}
+		open_batch = nullptr;
+		PlanLocked(*batch);
+		changed.notify_all();
+	}
+
+	auto group = self.group;
+	if (group->members.front() == &self) {
+		lk.unlock();
+		std::exception_ptr error;
+		try {
+			// Members are blocked until marked done below, so their buffers stay valid.
+			ExecuteGroup(*group);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		lk.lock();
+		for (auto member : group->members) {
+			member->error = error;
+			member->done = true;
+		}
+		changed.notify_all();
+	} else {
+		changed.wait(lk, [&self]() { return self.done; });
+	}
+	active_reads--;
+	lk.unlock();
+	if (self.error) {
+		std::rethrow_exception(self.error);
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,132 @@
+#include "s3redirect_readahead.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+S3RedirectReadahead::S3RedirectReadahead(S3RedirectTaskPool &task_pool_p, fetch_function_t fetch_p,
+                                         idx_t file_size_p, idx_t initial_window_p, idx_t max_window_p)
+    : task_pool(task_pool_p), fetch(std::move(fetch_p)), file_size(file_size_p),
+      initial_window(MaxValue<idx_t>(initial_window_p, 1)),
+      max_window(MaxValue<idx_t>(max_window_p, initial_window)), next_window_size(initial_window) {
+}
+
+S3RedirectReadahead::~S3RedirectReadahead() {
+	Reset();
+	std::unique_lock<std::mutex> lk(in_flight_lock);
+	in_flight_done.wait(lk, [this]() { return in_flight == 0; });
+}
+
+void S3RedirectReadahead::Reset() {
+	for (auto &window : windows) {
+		std::lock_guard<std::mutex> lk(window->lock);
+		if (window->state == WindowState::PENDING) {
+			window->state = WindowState::CANCELLED;
+		}
+	}
+	windows.clear();
+	next_window_size = initial_window;
+}
+
+void S3RedirectReadahead::RunWindow(Window &window) {
+	{
+		std::lock_guard<std::mutex> lk(window.lock);
+		if (window.state != WindowState::PENDING) {
+			return;
+		}
+		window.state = WindowState::RUNNING;
+	}
+	std::exception_ptr error;
+	try {
+		fetch(window.data.get(), window.length, window.offset);
+	} catch (...) {
+		error = std::current_exception();
+	}
+	{
+		std::lock_guard<std::mutex> lk(window.lock);
+		window.error = error;
+		window.state = WindowState::DONE;
+	}
+	window.done.notify_all();
+}
+
+void S3RedirectReadahead::ScheduleWindow(idx_t offset) {
+	auto window = make_shared_ptr<Window>();
+	window->offset = offset;
+	window->length = MinValue<idx_t>(next_window_size, file_size - offset);
+	window->data = make_unsafe_uniq_array_uninitialized<data_t>(window->length);
+	next_window_size = MinValue<idx_t>(next_window_size * 2, max_window);
+	windows.push_back(window);
+	{
+		std::lock_guard<std::mutex> lk(in_flight_lock);
+		in_flight++;
+	}
+	task_pool.Schedule([this, window]() {
+		RunWindow(*window);
+		// Notify under the lock: the destructor may free this object as soon as it sees zero.
+		std::lock_guard<std::mutex> lk(in_flight_lock);
+		in_flight--;
+		in_flight_done.notify_all();
+	});
+}
+
+void S3RedirectReadahead::FillQueue() {
+	while (windows.size() <= READAHEAD_DEPTH) {
+		auto &last = windows.back();
+		auto next_offset = last->offset + last->length;
+		if (next_offset >= file_size) {
+			return;
+		}
+		ScheduleWindow(next_offset);
+	}
+}
+
+void S3RedirectReadahead::WaitForWindow(Window &window) {
+	// Not picked up by a worker yet: fetch it on this thread rather than queue behind others.
+	RunWindow(window);
+	std::unique_lock<std::mutex> lk(window.lock);
+	window.done.wait(lk, [&window]() { return window.state == WindowState::DONE; });
+	if (window.error) {
+		std::rethrow_exception(window.error);
+	}
+}
+
+idx_t S3RedirectReadahead::Read(data_ptr_t buffer, idx_t nr_bytes, idx_t position) {
+	if (position >= file_size || nr_bytes == 0) {
+		return 0;
+	}
+	nr_bytes = MinValue<idx_t>(nr_bytes, file_size - position);
+	if (position != expected_position) {
+		Reset();
+	}
+	expected_position = position + nr_bytes;
+
+	idx_t done = 0;
+	while (done < nr_bytes) {
+		auto current = position + done;
+		while (!windows.empty() && windows.front()->offset + windows.front()->length <= current) {
+			windows.pop_front();
+		}
+		if (windows.empty() || windows.front()->offset > current) {
+			Reset();
+			ScheduleWindow(current);
+		}
+		FillQueue();
+		auto window = windows.front();
+		try {
+			WaitForWindow(*window);
+		} catch (...) {
+			// Drop the failed window so a retry fetches it again.
+			Reset();
+			expected_position = position;
+			throw;
+		}
+		auto window_end = window->offset + window->length;
+		auto count = MinValue<idx_t>(window_end - current, nr_bytes - done);
+		memcpy(buffer + done, window->data.get() + (current - window->offset), count);
+		done += count;
+	}
+	return nr_bytes;
+}
+
+} // namespace duckdb
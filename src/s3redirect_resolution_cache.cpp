@@ -0,0 +1,209 @@
+#include "s3redirect_resolution_cache.hpp"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+#include <errno.h>
+
+namespace duckdb {
+
+static std::atomic<uint64_t> next_cache_id {1};
+
+thread_local S3RedirectResolutionCache::ResolverSnapshot S3RedirectResolutionCache::resolver_snapshot;
+
+#ifdef __linux__
+static int64_t ToNanos(const struct timespec &time) {
+	return int64_t(time.tv_sec) * 1000000000 + int64_t(time.tv_nsec);
+}
+
+// Only answers that describe the file itself are worth caching; transient failures
+// (EACCES, EIO, daemon hiccups) are retried on the next lookup.
+static bool IsCacheable(const S3RedirectResolution &resolution) {
+	switch (resolution.error) {
+	case 0:
+	case ENODATA:
+	case ENOTSUP:
+	case S3RedirectResolution::EMPTY_XATTR_VALUE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// True when a redirectable resolution still lacks an attribute the open asked for.
+static bool NeedsProbe(const S3RedirectResolution &resolution, bool probe_residency, bool probe_etag) {
+	if (!resolution.IsRedirectable()) {
+		return false;
+	}
+	return (probe_residency && !resolution.info.residency) || (probe_etag && !resolution.info.etag_probed);
+}
+
+static void Probe(S3RedirectResolver &resolver, const string &local_path, S3RedirectResolution &resolution,
+                  bool probe_residency, bool probe_etag) {
+	if (!resolution.IsRedirectable()) {
+		return;
+	}
+	if (probe_residency && !resolution.info.residency) {
+		resolution.info.residency = resolver.ProbeResidency(local_path, resolution.info.content_length);
+	}
+	if (probe_etag && !resolution.info.etag_probed) {
+		resolution.info.etag = resolver.ProbeEtag(local_path);
+		resolution.info.etag_probed = true;
+	}
+}
+#endif
+
+S3RedirectResolution S3RedirectResolutionCache::ResolveUncached(const string &local_path) {
+#ifndef __linux__
+	S3RedirectResolution resolution;
+	resolution.error = ENOTSUP;
+	return resolution;
+#else
+	return S3RedirectXattrResolver().Resolve(local_path);
+#endif
+}
+
+S3RedirectResolutionCache::S3RedirectResolutionCache(idx_t capacity_p)
+    : capacity(capacity_p), cache_id(next_cache_id.fetch_add(1)), resolver(make_shared_ptr<S3RedirectXattrResolver>()),
+      resolver_name(S3RedirectXattrResolver::NAME),
+      resolver_xattr_namespace(S3RedirectXattrResolver::DEFAULT_NAMESPACE) {
+}
+
+void S3RedirectResolutionCache::SetResolver(const string &name, const string &manifest_path,
+                                            const string &xattr_namespace) {
+	{
+		std::lock_guard<std::mutex> lk(resolver_lock);
+		if (name == resolver_name && manifest_path == resolver_manifest_path &&
+		    xattr_namespace == resolver_xattr_namespace) {
+			return;
+		}
+		resolver = shared_ptr<S3RedirectResolver>(S3RedirectResolver::Create(name, manifest_path, xattr_namespace));
+		resolver_name = name;
+		resolver_manifest_path = manifest_path;
+		resolver_xattr_namespace = xattr_namespace;
+		resolver_generation.fetch_add(1, std::memory_order_release);
+	}
+	// Entries of the previous resolver may disagree with the new one.
+	Clear();
+}
+
+S3RedirectResolver &S3RedirectResolutionCache::GetResolver() {
+	auto &snapshot = resolver_snapshot;
+	if (snapshot.cache_id != cache_id || snapshot.generation != resolver_generation.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lk(resolver_lock);
+		snapshot.cache_id = cache_id;
+		snapshot.generation = resolver_generation.load(std::memory_order_relaxed);
+		snapshot.resolver = resolver;
+	}
+	return *snapshot.resolver;
+}
+
+S3RedirectResolutionCache::Shard &S3RedirectResolutionCache::GetShard(const string &local_path) {
+	return shards[std::hash<string>()(local_path) % SHARD_COUNT];
+}
+
+idx_t S3RedirectResolutionCache::ShardCapacity() const {
+	auto total = capacity.load(std::memory_order_relaxed);
+	return (total + SHARD_COUNT - 1) / SHARD_COUNT;
+}
+
+void S3RedirectResolutionCache::SetCapacity(idx_t capacity_p) {
+	capacity.store(capacity_p, std::memory_order_relaxed);
+}
+
+void S3RedirectResolutionCache::Clear() {
+	for (auto &shard : shards) {
+		std::lock_guard<std::mutex> lk(shard.lock);
+		shard.entries.clear();
+		shard.lru.clear();
+	}
+}
+
+S3RedirectResolution S3RedirectResolutionCache::Resolve(const string &local_path, bool probe_residency,
+                                                        bool probe_etag) {
+#ifndef __linux__
+	return ResolveUncached(local_path);
+#else
+	auto &current_resolver = GetResolver();
+	if (!current_resolver.UsesResolutionCache()) {
+		// Answers from memory: nothing to save by caching, and no stat to validate with.
+		auto resolution = current_resolver.Resolve(local_path);
+		Probe(current_resolver, local_path, resolution, probe_residency, probe_etag);
+		return resolution;
+	}
+	struct stat st;
+	if (stat(local_path.c_str(), &st) != 0) {
+		S3RedirectResolution resolution;
+		resolution.error = errno;
+		resolution.stat_failed = true;
+		return resolution;
+	}
+	auto inode = uint64_t(st.st_ino);
+	auto mtime_ns = ToNanos(st.st_mtim);
+	// CWIQ FS updating the xattrs (URL, ETag, residency) moves ctime but not mtime.
+	auto ctime_ns = ToNanos(st.st_ctim);
+	auto size = int64_t(st.st_size);
+
+	auto &shard = GetShard(local_path);
+	S3RedirectResolution resolution;
+	// A valid cached entry that only lacks an open-time probe.
+	bool cached_without_probe = false;
+	{
+		std::lock_guard<std::mutex> lk(shard.lock);
+		auto it = shard.entries.find(local_path);
+		if (it != shard.entries.end()) {
+			auto &entry = it->second;
+			if (entry.inode == inode && entry.mtime_ns == mtime_ns && entry.ctime_ns == ctime_ns &&
+			    entry.size == size) {
+				shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_position);
+				hits.fetch_add(1, std::memory_order_relaxed);
+				auto &cached = entry.resolution;
+				if (!NeedsProbe(cached, probe_residency, probe_etag)) {
+					return cached;
+				}
+				// Redirectable but never opened this way: probe below, outside the lock.
+				resolution = cached;
+				cached_without_probe = true;
+			}
+		}
+	}
+	if (!cached_without_probe) {
+		misses.fetch_add(1, std::memory_order_relaxed);
+		// Resolve outside the shard lock: getxattr is a round trip into the CWIQ FS daemon.
+		resolution = current_resolver.Resolve(local_path, st);
+	}
+	Probe(current_resolver, local_path, resolution, probe_residency, probe_etag);
+	if (!IsCacheable(resolution)) {
+		return resolution;
+	}
+	auto shard_capacity = ShardCapacity();
+	if (shard_capacity == 0) {
+		return resolution;
+	}
+
+	std::lock_guard<std::mutex> lk(shard.lock);
+	auto it = shard.entries.find(local_path);
+	if (it == shard.entries.end()) {
+		shard.lru.push_front(local_path);
+		it = shard.entries.emplace(local_path, Entry()).first;
+		it->second.lru_position = shard.lru.begin();
+	} else {
+		shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_position);
+	}
+	auto &entry = it->second;
+	entry.inode = inode;
+	entry.mtime_ns = mtime_ns;
+	entry.ctime_ns = ctime_ns;
+	entry.size = size;
+	entry.resolution = resolution;
+
+	while (shard.entries.size() > shard_capacity) {
+		shard.entries.erase(shard.lru.back());
+		shard.lru.pop_back();
+	}
+	return resolution;
+#endif
+}
+
+} // namespace duckdb
@@ -0,0 +1,576 @@
+#include "s3redirect_resolver.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/xattr.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace duckdb {
+
+static constexpr const char *S3_URL_ATTRIBUTE = "s3_url";
+static constexpr const char *RESIDENT_RANGES_ATTRIBUTE = "resident_ranges";
+static constexpr const char *ETAG_ATTRIBUTE = "etag";
+static constexpr const char *DIRECTORY_URLS_ATTRIBUTE = "dir_s3_urls";
+
+// S3 URLs and typical range lists are well under 1 KiB, so the common case is a single
+// getxattr() into this buffer.
+static constexpr idx_t XATTR_STACK_BUFFER_SIZE = 1024;
+
+void S3RedirectResolution::ThrowError(const string &local_path) const {
+	D_ASSERT(!IsRedirectable());
+	if (!error_message.empty()) {
+		throw IOException(error_message + " for " + local_path);
+	}
+	if (error == EMPTY_XATTR_VALUE) {
+		throw IOException("Empty xattr value for " + local_path);
+	}
+	if (stat_failed) {
+		throw IOException("Failed to stat file " + local_path + ": " + strerror(error));
+	}
+	auto attribute_name = attribute.empty()
+	                          ? string(S3RedirectXattrResolver::DEFAULT_NAMESPACE) + "." + S3_URL_ATTRIBUTE
+	                          : attribute;
+	string error_msg = "Failed to get xattr '" + attribute_name + "' for " + local_path + ": ";
+	switch (error) {
+	case ENODATA:
+		error_msg += "attribute does not exist";
+		break;
+	case ENOENT:
+		error_msg += "file does not exist";
+		break;
+	case EACCES:
+		error_msg += "permission denied";
+		break;
+	case ENOTSUP:
+		error_msg += "xattrs not supported on this filesystem";
+		break;
+	default:
+		error_msg += strerror(error);
+	}
+	throw IOException(error_msg);
+}
+
+shared_ptr<const S3RedirectResidency> S3RedirectResidency::Parse(const string &value, idx_t file_size) {
+	auto residency = make_shared_ptr<S3RedirectResidency>();
+	auto trimmed = value;
+	StringUtil::Trim(trimmed);
+	if (trimmed == "all") {
+		if (file_size > 0) {
+			residency->ranges.emplace_back(0, file_size);
+		}
+		return residency;
+	}
+	if (trimmed.empty() || trimmed == "none") {
+		return residency;
+	}
+	vector<std::pair<idx_t, idx_t>> ranges;
+	for (auto &part : StringUtil::Split(trimmed, ',')) {
+		auto dash = part.find('-');
+		if (dash == string::npos) {
+			return make_shared_ptr<S3RedirectResidency>();
+		}
+		char *start_end = nullptr;
+		char *end_end = nullptr;
+		auto start_text = part.substr(0, dash);
+		auto end_text = part.substr(dash + 1);
+		errno = 0;
+		auto start = strtoull(start_text.c_str(), &start_end, 10);
+		auto end = strtoull(end_text.c_str(), &end_end, 10);
+		if (errno != 0 || start_text.empty() || end_text.empty() || *start_end != '\0' || *end_end != '\0') {
+			return make_shared_ptr<S3RedirectResidency>();
+		}
+		end = MinValue<idx_t>(end, file_size);
+		if (start < end) {
+			ranges.emplace_back(start, end);
+		}
+	}
+	std::sort(ranges.begin(), ranges.end());
+	for (auto &range : ranges) {
+		if (!residency->ranges.empty() && range.first <= residency->ranges.back().second) {
+			residency->ranges.back().second = MaxValue<idx_t>(residency->ranges.back().second, range.second);
+		} else {
+			residency->ranges.push_back(range);
+		}
+	}
+	return residency;
+}
+
+static int64_t ModificationTimeNanos(const struct stat &st) {
+#ifdef __linux__
+	return int64_t(st.st_mtim.tv_sec) * 1000000000 + int64_t(st.st_mtim.tv_nsec);
+#else
+	return int64_t(st.st_mtime) * 1000000000;
+#endif
+}
+
+static int64_t ChangeTimeNanos(const struct stat &st) {
+#ifdef __linux__
+	return int64_t(st.st_ctim.tv_sec) * 1000000000 + int64_t(st.st_ctim.tv_nsec);
+#else
+	return int64_t(st.st_ctime) * 1000000000;
+#endif
+}
+
+string S3RedirectInfo::ObjectKey() const {
+	auto key = s3_url + "@" + std::to_string(content_length) + "@" + std::to_string(mtime_ns);
+	if (!etag.empty()) {
+		key += "@" + etag;
+	}
+	return key;
+}
+
+// ---------------------------------------------------------------------------
+// S3RedirectResolver
+// ---------------------------------------------------------------------------
+
+S3RedirectResolution S3RedirectResolver::Resolve(const string &local_path) {
+	struct stat st;
+	if (stat(local_path.c_str(), &st) != 0) {
+		S3RedirectResolution resolution;
+		resolution.error = errno;
+		resolution.stat_failed = true;
+		return resolution;
+	}
+	return Resolve(local_path, st);
+}
+
+shared_ptr<const S3RedirectResidency> S3RedirectResolver::ProbeResidency(const string &local_path,
+                                                                         idx_t file_size) {
+	return make_shared_ptr<S3RedirectResidency>();
+}
+
+string S3RedirectResolver::ProbeEtag(const string &local_path) {
+	return string();
+}
+
+unique_ptr<S3RedirectResolver> S3RedirectResolver::Create(const string &name, const string &manifest_path,
+                                                          const string &xattr_namespace) {
+	auto lower = StringUtil::Lower(name);
+	if (lower == S3RedirectXattrResolver::NAME) {
+		return make_uniq<S3RedirectXattrResolver>(xattr_namespace);
+	}
+	if (lower == S3RedirectBatchResolver::NAME) {
+		return make_uniq<S3RedirectBatchResolver>(xattr_namespace);
+	}
+	if (lower == S3RedirectManifestResolver::NAME) {
+		return make_uniq<S3RedirectManifestResolver>(manifest_path);
+	}
+	throw InvalidInputException("Unknown cwiqduck resolver '%s'; expected 'xattr', 'manifest' or 'batch'", name);
+}
+
+// ---------------------------------------------------------------------------
+// S3RedirectXattrResolver
+// ---------------------------------------------------------------------------
+
+// Reads an xattr with one syscall in the common case. Only a value larger than the stack buffer
+// (ERANGE) falls back to the size-probe + heap-read sequence. Returns 0 or an errno.
+static int ReadXattr(const string &local_path, const string &name, string &result) {
+#ifndef __linux__
+	return ENOTSUP;
+#else
+	char stack_buffer[XATTR_STACK_BUFFER_SIZE];
+	ssize_t size = getxattr(local_path.c_str(), name.c_str(), stack_buffer, sizeof(stack_buffer));
+	if (size >= 0) {
+		result.assign(stack_buffer, size);
+		return 0;
+	}
+	while (errno == ERANGE) {
+		size = getxattr(local_path.c_str(), name.c_str(), nullptr, 0);
+		if (size < 0) {
+			break;
+		}
+		vector<char> heap_buffer(size);
+		// The value may have grown between the two calls; retry on ERANGE.
+		ssize_t actual_size = getxattr(local_path.c_str(), name.c_str(), heap_buffer.data(), size);
+		if (actual_size >= 0) {
+			result.assign(heap_buffer.data(), actual_size);
+			return 0;
+		}
+	}
+	return errno;
+#endif
+}
+
+S3RedirectXattrResolver::S3RedirectXattrResolver(const string &xattr_namespace_p)
+    : xattr_namespace(xattr_namespace_p.empty() ? DEFAULT_NAMESPACE : xattr_namespace_p),
+      s3_url_attribute(xattr_namespace + "." + S3_URL_ATTRIBUTE) {
+}
+
+int S3RedirectXattrResolver::ReadAttribute(const string &local_path, const char *attribute, string &result) const {
+	return ReadXattr(local_path, xattr_namespace + "." + attribute, result);
+}
+
+static S3RedirectResolution RedirectTo(string s3_url, const struct stat &st) {
+	S3RedirectResolution resolution;
+	if (s3_url.empty()) {
+		resolution.error = S3RedirectResolution::EMPTY_XATTR_VALUE;
+		return resolution;
+	}
+	resolution.info.s3_url = std::move(s3_url);
+	resolution.info.content_length = st.st_size;
+	resolution.info.last_modified_time = Timestamp::FromEpochSeconds(st.st_mtime);
+	resolution.info.mtime_ns = ModificationTimeNanos(st);
+	return resolution;
+}
+
+S3RedirectResolution S3RedirectXattrResolver::Resolve(const string &local_path, const struct stat &st) {
+	string s3_url;
+	auto error = ReadXattr(local_path, s3_url_attribute, s3_url);
+	if (error != 0) {
+		S3RedirectResolution resolution;
+		resolution.error = error;
+		resolution.attribute = s3_url_attribute;
+		return resolution;
+	}
+	return RedirectTo(std::move(s3_url), st);
+}
+
+shared_ptr<const S3RedirectResidency> S3RedirectXattrResolver::ProbeResidency(const string &local_path,
+                                                                              idx_t file_size) {
+	string value;
+	if (ReadAttribute(local_path, RESIDENT_RANGES_ATTRIBUTE, value) == 0) {
+		return S3RedirectResidency::Parse(value, file_size);
+	}
+	return make_shared_ptr<S3RedirectResidency>();
+}
+
+string S3RedirectXattrResolver::ProbeEtag(const string &local_path) {
+	string etag;
+	if (ReadAttribute(local_path, ETAG_ATTRIBUTE, etag) != 0) {
+		etag.clear();
+	}
+	return etag;
+}
+
+// ---------------------------------------------------------------------------
+// S3RedirectBatchResolver
+// ---------------------------------------------------------------------------
+
+shared_ptr<S3RedirectBatchResolver::Listing> S3RedirectBatchResolver::GetListing(const string &directory) {
+	std::lock_guard<std::mutex> lk(lock);
+	if (listings.size() >= MAX_LISTINGS && listings.find(directory) == listings.end()) {
+		listings.clear();
+	}
+	auto &listing = listings[directory];
+	if (!listing) {
+		listing = make_shared_ptr<Listing>();
+	}
+	return listing;
+}
+
+int S3RedirectBatchResolver::LoadListing(const string &directory, std::unordered_map<string, string> &urls) const {
+	for (idx_t page = 0; page < MAX_LISTING_PAGES; page++) {
+		auto attribute = page == 0 ? string(DIRECTORY_URLS_ATTRIBUTE)
+		                           : string(DIRECTORY_URLS_ATTRIBUTE) + "." + std::to_string(page);
+		string value;
+		auto error = ReadAttribute(directory, attribute.c_str(), value);
+		if (error != 0) {
+			urls.clear();
+			return error;
+		}
+		bool more = false;
+		for (auto &line : StringUtil::Split(value, '\n')) {
+			auto tab = line.find('\t');
+			if (tab != string::npos && tab > 0) {
+				urls[line.substr(0, tab)] = line.substr(tab + 1);
+			} else if (line == LISTING_CONTINUATION) {
+				more = true;
+			}
+		}
+		if (!more) {
+			return 0;
+		}
+	}
+	urls.clear();
+	return E2BIG;
+}
+
+S3RedirectResolution S3RedirectBatchResolver::Resolve(const string &local_path, const struct stat &st) {
+	auto slash = local_path.find_last_of('/');
+	if (slash == string::npos) {
+		return S3RedirectXattrResolver::Resolve(local_path, st);
+	}
+	auto directory = slash == 0 ? string("/") : local_path.substr(0, slash);
+	auto name = local_path.substr(slash + 1);
+	struct stat directory_st;
+	if (stat(directory.c_str(), &directory_st) != 0) {
+		return S3RedirectXattrResolver::Resolve(local_path, st);
+	}
+
+	auto listing = GetListing(directory);
+	// Held while loading, so concurrent lookups in one directory (a parallel glob) wait for a
+	// single load instead of each issuing their own.
+	std::unique_lock<std::mutex> lk(listing->lock);
+	auto inode = uint64_t(directory_st.st_ino);
+	auto mtime_ns = ModificationTimeNanos(directory_st);
+	auto ctime_ns = ChangeTimeNanos(directory_st);
+	if (!listing->loaded || listing->inode != inode || listing->mtime_ns != mtime_ns ||
+	    listing->ctime_ns != ctime_ns) {
+		listing->urls.clear();
+		listing->error = LoadListing(directory, listing->urls);
+		listing->inode = inode;
+		listing->mtime_ns = mtime_ns;
+		listing->ctime_ns = ctime_ns;
+		listing->loaded = true;
+	}
+	if (listing->error != 0) {
+		// No listing for this directory (e.g. an older mount): ask the file itself.
+		lk.unlock();
+		return S3RedirectXattrResolver::Resolve(local_path, st);
+	}
+	auto entry = listing->urls.find(name);
+	if (entry == listing->urls.end()) {
+		S3RedirectResolution resolution;
+		resolution.error = ENODATA;
+		resolution.attribute = s3_url_attribute;
+		return resolution;
+	}
+	return RedirectTo(entry->second, st);
+}
+
+// ---------------------------------------------------------------------------
+// S3RedirectManifestResolver
+// ---------------------------------------------------------------------------
+
+struct S3RedirectManifestResolver::Mapping {
+	struct Entry {
+		idx_t path_offset;
+		idx_t path_length;
+		idx_t url_offset;
+		idx_t url_length;
+		idx_t size;
+		int64_t mtime;
+		// Zero length when the line has no etag field.
+		idx_t etag_offset;
+		idx_t etag_length;
+	};
+	struct Slot {
+		uint64_t hash;
+		// Index into entries + 1; 0 marks an empty slot.
+		idx_t entry;
+	};
+
+	~Mapping() {
+#ifdef __linux__
+		if (data) {
+			munmap(const_cast<char *>(data), size);
+		}
+#endif
+	}
+
+	const char *data = nullptr;
+	idx_t size = 0;
+	uint64_t inode = 0;
+	int64_t mtime_ns = 0;
+	// Set when the manifest could not be loaded; every lookup then fails with it.
+	string error;
+	vector<Entry> entries;
+	vector<Slot> slots;
+};
+
+static uint64_t HashPath(const char *data, idx_t length) {
+	// FNV-1a: no allocation, and hashes the mapped bytes in place.
+	uint64_t hash = 14695981039346656037ULL;
+	for (idx_t i = 0; i < length; i++) {
+		hash ^= uint8_t(data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Parses a decimal field; false when it is empty or not all digits.
+static bool ParseNumber(const char *begin, const char *end, idx_t &result) {
+	if (begin == end) {
+		return false;
+	}
+	result = 0;
+	for (auto p = begin; p < end; p++) {
+		if (*p < '0' || *p > '9') {
+			return false;
+		}
+		result = result * 10 + idx_t(*p - '0');
+	}
+	return true;
+}
+
+static std::atomic<uint64_t> next_manifest_resolver_id {1};
+
+thread_local S3RedirectManifestResolver::MappingCache S3RedirectManifestResolver::mapping_cache;
+
+S3RedirectManifestResolver::S3RedirectManifestResolver(string manifest_path_p)
+    : manifest_path(std::move(manifest_path_p)), resolver_id(next_manifest_resolver_id.fetch_add(1)) {
+}
+
+shared_ptr<const S3RedirectManifestResolver::Mapping> S3RedirectManifestResolver::Load(const string &path) {
+	auto mapping = make_shared_ptr<Mapping>();
+	if (path.empty()) {
+		mapping->error = "cwiqduck_manifest_path is not set";
+		return std::move(mapping);
+	}
+#ifndef __linux__
+	mapping->error = "CWIQ FS manifests are only supported on Linux";
+	return std::move(mapping);
+#else
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		mapping->error = "Failed to open CWIQ FS manifest '" + path + "': " + strerror(errno);
+		if (fd >= 0) {
+			close(fd);
+		}
+		return std::move(mapping);
+	}
+	mapping->inode = uint64_t(st.st_ino);
+	mapping->mtime_ns = ModificationTimeNanos(st);
+	if (st.st_size > 0) {
+		auto data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			mapping->error = "Failed to map CWIQ FS manifest '" + path + "': " + strerror(errno);
+			close(fd);
+			return std::move(mapping);
+		}
+		mapping->data = static_cast<const char *>(data);
+		mapping->size = idx_t(st.st_size);
+	}
+	close(fd);
+
+	// One pass over the lines: record the field offsets of every well-formed entry.
+	auto data = mapping->data;
+	auto end = data + mapping->size;
+	for (auto line = data; line < end;) {
+		auto line_end = static_cast<const char *>(memchr(line, '\n', end - line));
+		if (!line_end) {
+			line_end = end;
+		}
+		const char *fields[5];
+		const char *field_ends[5];
+		idx_t field_count = 0;
+		for (auto field = line; field_count < 5 && field <= line_end;) {
+			auto tab = static_cast<const char *>(memchr(field, '\t', line_end - field));
+			auto field_end = tab ? tab : line_end;
+			fields[field_count] = field;
+			field_ends[field_count] = field_end;
+			field_count++;
+			field = field_end + 1;
+		}
+		Mapping::Entry entry;
+		idx_t mtime;
+		if (field_count >= 4 && fields[0] < field_ends[0] && fields[1] < field_ends[1] &&
+		    ParseNumber(fields[2], field_ends[2], entry.size) && ParseNumber(fields[3], field_ends[3], mtime)) {
+			entry.path_offset = idx_t(fields[0] - data);
+			entry.path_length = idx_t(field_ends[0] - fields[0]);
+			entry.url_offset = idx_t(fields[1] - data);
+			entry.url_length = idx_t(field_ends[1] - fields[1]);
+			entry.mtime = int64_t(mtime);
+			entry.etag_offset = field_count == 5 ? idx_t(fields[4] - data) : 0;
+			entry.etag_length = field_count == 5 ? idx_t(field_ends[4] - fields[4]) : 0;
+			mapping->entries.push_back(entry);
+		}
+		line = line_end + 1;
+	}
+
+	// Open addressing at a load factor of at most 1/2; later duplicates of a path win.
+	idx_t slot_count = 16;
+	while (slot_count < mapping->entries.size() * 2) {
+		slot_count *= 2;
+	}
+	mapping->slots.resize(slot_count, Mapping::Slot {0, 0});
+	for (idx_t i = 0; i < mapping->entries.size(); i++) {
+		auto &entry = mapping->entries[i];
+		auto hash = HashPath(data + entry.path_offset, entry.path_length);
+		for (auto slot = hash & (slot_count - 1);; slot = (slot + 1) & (slot_count - 1)) {
+			auto &candidate = mapping->slots[slot];
+			if (candidate.entry == 0) {
+				candidate = {hash, i + 1};
+				break;
+			}
+			auto &existing = mapping->entries[candidate.entry - 1];
+			if (candidate.hash == hash && existing.path_length == entry.path_length &&
+			    memcmp(data + existing.path_offset, data + entry.path_offset, entry.path_length) == 0) {
+				candidate.entry = i + 1;
+				break;
+			}
+		}
+	}
+	return std::move(mapping);
+#endif
+}
+
+static int64_t MonotonicMicros() {
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return int64_t(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+const S3RedirectManifestResolver::Mapping &S3RedirectManifestResolver::GetMapping() {
+	auto now = MonotonicMicros();
+	if (now >= next_check_us.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lk(lock);
+		if (now >= next_check_us.load(std::memory_order_relaxed)) {
+			struct stat st;
+			bool unchanged = mapping && stat(manifest_path.c_str(), &st) == 0 && mapping->error.empty() &&
+			                 mapping->inode == uint64_t(st.st_ino) &&
+			                 mapping->mtime_ns == ModificationTimeNanos(st);
+			if (!unchanged) {
+				// Threads still holding the old mapping keep it alive until they pick up this one.
+				mapping = Load(manifest_path);
+				generation.fetch_add(1, std::memory_order_release);
+			}
+			next_check_us.store(now + RECHECK_INTERVAL_US, std::memory_order_release);
+		}
+	}
+	auto &cache = mapping_cache;
+	if (cache.resolver_id != resolver_id || cache.generation != generation.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lk(lock);
+		cache.resolver_id = resolver_id;
+		cache.generation = generation.load(std::memory_order_relaxed);
+		cache.mapping = mapping;
+	}
+	return *cache.mapping;
+}
+
+S3RedirectResolution S3RedirectManifestResolver::Resolve(const string &local_path) {
+	auto &current = GetMapping();
+	S3RedirectResolution resolution;
+	if (!current.error.empty()) {
+		resolution.error = EIO;
+		resolution.error_message = current.error;
+		return resolution;
+	}
+	if (!current.entries.empty()) {
+		auto hash = HashPath(local_path.data(), local_path.size());
+		auto mask = current.slots.size() - 1;
+		for (auto slot = hash & mask; current.slots[slot].entry != 0; slot = (slot + 1) & mask) {
+			auto &candidate = current.slots[slot];
+			auto &entry = current.entries[candidate.entry - 1];
+			if (candidate.hash != hash || entry.path_length != local_path.size() ||
+			    memcmp(current.data + entry.path_offset, local_path.data(), local_path.size()) != 0) {
+				continue;
+			}
+			resolution.info.s3_url.assign(current.data + entry.url_offset, entry.url_length);
+			resolution.info.content_length = entry.size;
+			resolution.info.last_modified_time = Timestamp::FromEpochSeconds(entry.mtime);
+			resolution.info.mtime_ns = entry.mtime * 1000000000;
+			// Everything the manifest knows is known now; there is nothing to probe at open.
+			resolution.info.etag.assign(current.data + entry.etag_offset, entry.etag_length);
+			resolution.info.etag_probed = true;
+			return resolution;
+		}
+	}
+	resolution.error = ENODATA;
+	resolution.error_message = "Path is not in the CWIQ FS manifest '" + manifest_path + "'";
+	return resolution;
+}
+
+} // namespace duckdb
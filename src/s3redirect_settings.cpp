@@ -0,0 +1,248 @@
+#include "s3redirect_settings.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/config.hpp"
+#include "s3redirect_resolver.hpp"
+
+#include <atomic>
+
+namespace duckdb {
+
+static std::atomic<idx_t> path_settings_generation {0};
+
+// Options are only read database-wide (see AddOption): a SESSION or LOCAL value would show up in
+// current_setting() and never take effect, so it is refused. A plain SET arrives as AUTOMATIC and
+// is stored globally.
+static void CheckScope(SetScope scope) {
+	if (scope != SetScope::AUTOMATIC && scope != SetScope::GLOBAL) {
+		throw InvalidInputException("cwiqduck_* options are global; use SET or SET GLOBAL");
+	}
+}
+
+static void SetGlobalOption(ClientContext &context, SetScope scope, Value &parameter) {
+	CheckScope(scope);
+}
+
+// DuckDB runs set callbacks before it stores the value, so the path options are stored here
+// first and only then announced: a refresh racing the SET can then never cache the old value
+// under the new generation.
+static void StorePathOption(ClientContext &context, SetScope scope, const char *name, const Value &parameter) {
+	CheckScope(scope);
+	DBConfig::GetConfig(context).SetOption(name, parameter);
+	path_settings_generation.fetch_add(1, std::memory_order_release);
+}
+
+// Rejects an unknown resolver at SET time rather than on the next file access.
+static void SetResolver(ClientContext &context, SetScope scope, Value &parameter) {
+	auto name = StringUtil::Lower(parameter.ToString());
+	if (name != S3RedirectXattrResolver::NAME && name != S3RedirectBatchResolver::NAME &&
+	    name != S3RedirectManifestResolver::NAME) {
+		throw InvalidInputException("Unknown cwiqduck_resolver '%s'; expected 'xattr', 'batch' or 'manifest'",
+		                            parameter.ToString());
+	}
+	StorePathOption(context, scope, S3RedirectSettings::RESOLVER, parameter);
+}
+
+static void SetManifestPath(ClientContext &context, SetScope scope, Value &parameter) {
+	StorePathOption(context, scope, S3RedirectSettings::MANIFEST_PATH, parameter);
+}
+
+static void SetXattrNamespace(ClientContext &context, SetScope scope, Value &parameter) {
+	auto name_space = parameter.ToString();
+	if (name_space.empty() || name_space.front() == '.' || name_space.back() == '.') {
+		throw InvalidInputException("Invalid cwiqduck_xattr_namespace '%s'; expected e.g. 'system.cwiqfs'",
+		                            name_space);
+	}
+	StorePathOption(context, scope, S3RedirectSettings::XATTR_NAMESPACE, parameter);
+}
+
+static void SetWriteBufferSize(ClientContext &context, SetScope scope, Value &parameter) {
+	StorePathOption(context, scope, S3RedirectSettings::WRITE_BUFFER_SIZE, parameter);
+}
+
+static void SetMountFilesystemType(ClientContext &context, SetScope scope, Value &parameter) {
+	StorePathOption(context, scope, S3RedirectSettings::MOUNT_FILESYSTEM_TYPE, parameter);
+}
+
+static void SetMountPaths(ClientContext &context, SetScope scope, Value &parameter) {
+	StorePathOption(context, scope, S3RedirectSettings::MOUNT_PATHS, parameter);
+}
+
+// Every option is GLOBAL. The caches, pools and scheduler they configure are shared by all
+// connections, and paths are resolved (CanHandleFile) without any client context, so settings are
+// read through DatabaseInstance::TryGetCurrentSetting, which only sees global values. Registered
+// with the default SESSION scope, a plain SET would be visible to current_setting() but never
+// reach the filesystem. Options without a callback of their own still get the scope check.
+static void AddOption(DBConfig &config, const char *name, const string &description, const LogicalType &type,
+                      const Value &default_value, set_option_callback_t set_function = SetGlobalOption) {
+	config.AddExtensionOption(name, description, type, default_value, set_function, SetScope::GLOBAL);
+}
+
+void S3RedirectSettings::Register(DBConfig &config) {
+	S3RedirectSettings defaults;
+	AddOption(config, RESOLUTION_CACHE_ENTRIES,
+	          "Maximum number of CWIQ FS path resolutions (xattr lookups) kept in memory", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.resolution_cache_entries));
+	AddOption(config, SEED_HTTP_METADATA,
+	          "Open redirected S3 objects with the size, mtime and ETag known from CWIQ FS instead of a HEAD",
+	          LogicalType::BOOLEAN, Value::BOOLEAN(defaults.seed_http_metadata));
+	AddOption(config, POOL_MAX_HANDLES_PER_OBJECT,
+	          "Maximum idle httpfs handles kept per redirected object in the shared pool", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.pool_max_handles_per_object));
+	AddOption(config, POOL_MAX_HANDLES, "Maximum idle httpfs handles kept in the shared pool overall",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.pool_max_handles));
+	AddOption(config, POOL_TARGET_HANDLES,
+	          "Idle httpfs handles the pool is shrunk back to once a burst of reads is over", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.pool_target_handles));
+	AddOption(config, POOL_IDLE_TIMEOUT_MS, "Milliseconds after which an idle pooled httpfs handle is closed",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.pool_idle_timeout_ms));
+	AddOption(config, BLOCK_CACHE_SIZE,
+	          "Memory budget in bytes for cached blocks of redirected objects, on top of memory_limit (0 disables "
+	          "the cache)",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.block_cache_size));
+	AddOption(config, BLOCK_CACHE_BLOCK_SIZE, "Size in bytes of the aligned blocks kept in the block cache",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.block_cache_block_size));
+	AddOption(config, DISK_CACHE_PATH,
+	          "Local directory for the persistent chunk cache of redirected objects (empty disables it)",
+	          LogicalType::VARCHAR, Value(defaults.disk_cache_path));
+	AddOption(config, DISK_CACHE_SIZE, "Size cap in bytes of the persistent chunk cache", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.disk_cache_size));
+	AddOption(config, IO_THREADS, "Maximum number of background I/O threads used for redirected reads",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.io_threads));
+	AddOption(config, READAHEAD_INITIAL_WINDOW, "Initial sequential readahead window in bytes for redirected files",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.readahead_initial_window));
+	AddOption(config, READAHEAD_MAX_WINDOW,
+	          "Maximum sequential readahead window in bytes for redirected files (0 disables readahead)",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.readahead_max_window));
+	AddOption(config, PARALLEL_READ_THRESHOLD,
+	          "Positional reads of at least this many bytes are split into parallel ranged GETs", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.parallel_read_threshold));
+	AddOption(config, PARALLEL_READ_PART_SIZE, "Size in bytes of each ranged GET of a split read", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.parallel_read_part_size));
+	AddOption(config, PARALLEL_READ_MAX_PARTS,
+	          "Maximum ranged GETs in flight for one split read (1 disables splitting)", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.parallel_read_max_parts));
+	AddOption(config, COALESCE_WINDOW_US,
+	          "Microseconds a burst of concurrent reads waits to be merged into one GET (0 disables it)",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.coalesce_window_us));
+	AddOption(config, COALESCE_MAX_GAP, "Largest gap in bytes between two reads that are still merged",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.coalesce_max_gap));
+	AddOption(config, SINGLE_FLIGHT, "Let concurrent reads of the same range of a redirected object share one GET",
+	          LogicalType::BOOLEAN, Value::BOOLEAN(defaults.single_flight));
+	AddOption(config, HEDGED_READS,
+	          "Send a duplicate range GET when a read of a redirected object exceeds its latency deadline",
+	          LogicalType::BOOLEAN, Value::BOOLEAN(defaults.hedged_reads));
+	AddOption(config, HEDGE_PERCENTILE, "Per-endpoint latency percentile after which a read is hedged",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.hedge_percentile));
+	AddOption(config, HEDGE_MAX_RATIO, "Maximum hedged reads as a percentage of all reads per endpoint",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.hedge_max_ratio));
+	AddOption(config, HEDGE_MIN_DELAY_MS, "Minimum milliseconds before a read is hedged", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.hedge_min_delay_ms));
+	AddOption(config, LOCAL_FIRST,
+	          "Read ranges that the CWIQ FS mount already holds locally from the mount instead of S3",
+	          LogicalType::BOOLEAN, Value::BOOLEAN(defaults.local_first));
+	AddOption(config, GLOB_THREADS, "Number of threads resolving CWIQ FS glob matches in parallel",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.glob_threads));
+	AddOption(config, PARQUET_FOOTER_PREFETCH,
+	          "Bytes at the end of a redirected parquet file prefetched when it is opened (0 disables it)",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.parquet_footer_prefetch));
+	AddOption(config, PREFETCH_BUDGET,
+	          "Maximum prefetched bytes held per open redirected file (0 disables prefetching)", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.prefetch_budget));
+	AddOption(config, MAX_IN_FLIGHT,
+	          "Maximum concurrent range GETs for redirected files (0 disables the I/O scheduler)", LogicalType::UBIGINT,
+	          Value::UBIGINT(defaults.max_in_flight));
+	AddOption(config, MAX_IN_FLIGHT_PER_ENDPOINT,
+	          "Maximum concurrent range GETs per bucket before throttling backoff (0: global cap only)",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.max_in_flight_per_endpoint));
+	AddOption(config, RESOLVER, "Source of CWIQ FS path mappings: 'xattr', 'batch' or 'manifest'", LogicalType::VARCHAR,
+	          Value(defaults.resolver), SetResolver);
+	AddOption(config, MANIFEST_PATH, "Path mapping manifest exported by CWIQ FS, used by the manifest resolver",
+	          LogicalType::VARCHAR, Value(defaults.manifest_path), SetManifestPath);
+	AddOption(config, XATTR_NAMESPACE,
+	          "Namespace of the CWIQ FS xattrs read by the xattr and batch resolvers (only for test fixtures)",
+	          LogicalType::VARCHAR, Value(defaults.xattr_namespace), SetXattrNamespace);
+	AddOption(config, SMALL_OBJECT_THRESHOLD,
+	          "Redirected objects up to this many bytes are fetched whole when opened (0 disables it)",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.small_object_threshold));
+	AddOption(config, WRITE_BUFFER_SIZE,
+	          "Buffer size in bytes for write-only opens of files on a CWIQ FS mount (0 disables write buffering)",
+	          LogicalType::UBIGINT, Value::UBIGINT(defaults.write_buffer_size), SetWriteBufferSize);
+	AddOption(config, MOUNT_FILESYSTEM_TYPE,
+	          "Filesystem type (as in /proc/self/mounts) of CWIQ FS mounts; empty matches no mount",
+	          LogicalType::VARCHAR, Value(defaults.mount_filesystem_type), SetMountFilesystemType);
+	AddOption(config, MOUNT_PATHS, "Comma-separated directories treated as CWIQ FS mounts in addition to the real ones",
+	          LogicalType::VARCHAR, Value(defaults.mount_paths), SetMountPaths);
+}
+
+template <class T>
+static void FetchSetting(DatabaseInstance &db, const char *name, T &target) {
+	Value value;
+	if (db.TryGetCurrentSetting(name, value) && !value.IsNull()) {
+		target = value.GetValue<T>();
+	}
+}
+
+S3RedirectSettings S3RedirectSettings::Fetch(DatabaseInstance &db) {
+	S3RedirectSettings settings;
+	FetchSetting(db, RESOLUTION_CACHE_ENTRIES, settings.resolution_cache_entries);
+	FetchSetting(db, SEED_HTTP_METADATA, settings.seed_http_metadata);
+	FetchSetting(db, POOL_MAX_HANDLES_PER_OBJECT, settings.pool_max_handles_per_object);
+	FetchSetting(db, POOL_MAX_HANDLES, settings.pool_max_handles);
+	FetchSetting(db, POOL_TARGET_HANDLES, settings.pool_target_handles);
+	FetchSetting(db, POOL_IDLE_TIMEOUT_MS, settings.pool_idle_timeout_ms);
+	FetchSetting(db, BLOCK_CACHE_SIZE, settings.block_cache_size);
+	FetchSetting(db, BLOCK_CACHE_BLOCK_SIZE, settings.block_cache_block_size);
+	FetchSetting(db, DISK_CACHE_PATH, settings.disk_cache_path);
+	FetchSetting(db, DISK_CACHE_SIZE, settings.disk_cache_size);
+	FetchSetting(db, IO_THREADS, settings.io_threads);
+	FetchSetting(db, READAHEAD_INITIAL_WINDOW, settings.readahead_initial_window);
+	FetchSetting(db, READAHEAD_MAX_WINDOW, settings.readahead_max_window);
+	FetchSetting(db, PARALLEL_READ_THRESHOLD, settings.parallel_read_threshold);
+	FetchSetting(db, PARALLEL_READ_PART_SIZE, settings.parallel_read_part_size);
+	FetchSetting(db, PARALLEL_READ_MAX_PARTS, settings.parallel_read_max_parts);
+	FetchSetting(db, COALESCE_WINDOW_US, settings.coalesce_window_us);
+	FetchSetting(db, COALESCE_MAX_GAP, settings.coalesce_max_gap);
+	FetchSetting(db, SINGLE_FLIGHT, settings.single_flight);
+	FetchSetting(db, HEDGED_READS, settings.hedged_reads);
+	FetchSetting(db, HEDGE_PERCENTILE, settings.hedge_percentile);
+	FetchSetting(db, HEDGE_MAX_RATIO, settings.hedge_max_ratio);
+	FetchSetting(db, HEDGE_MIN_DELAY_MS, settings.hedge_min_delay_ms);
+	FetchSetting(db, LOCAL_FIRST, settings.local_first);
+	FetchSetting(db, GLOB_THREADS, settings.glob_threads);
+	FetchSetting(db, PARQUET_FOOTER_PREFETCH, settings.parquet_footer_prefetch);
+	FetchSetting(db, PREFETCH_BUDGET, settings.prefetch_budget);
+	FetchSetting(db, MAX_IN_FLIGHT, settings.max_in_flight);
+	FetchSetting(db, MAX_IN_FLIGHT_PER_ENDPOINT, settings.max_in_flight_per_endpoint);
+	FetchSetting(db, SMALL_OBJECT_THRESHOLD, settings.small_object_threshold);
+	FetchPathSettings(db, settings);
+	return settings;
+}
+
+idx_t S3RedirectSettings::GetPathSettingsGeneration() {
+	return path_settings_generation.load(std::memory_order_acquire);
+}
+
+void S3RedirectSettings::FetchPathSettings(DatabaseInstance &db, S3RedirectSettings &settings) {
+	FetchSetting(db, RESOLVER, settings.resolver);
+	FetchSetting(db, MANIFEST_PATH, settings.manifest_path);
+	FetchSetting(db, XATTR_NAMESPACE, settings.xattr_namespace);
+	FetchSetting(db, WRITE_BUFFER_SIZE, settings.write_buffer_size);
+	FetchSetting(db, MOUNT_FILESYSTEM_TYPE, settings.mount_filesystem_type);
+	FetchSetting(db, MOUNT_PATHS, settings.mount_paths);
+}
+
+vector<string> S3RedirectSettings::GetMountPaths() const {
+	vector<string> paths;
+	for (auto &path : StringUtil::Split(mount_paths, ',')) {
+		auto trimmed = path;
+		StringUtil::Trim(trimmed);
+		if (!trimmed.empty()) {
+			paths.push_back(std::move(trimmed));
+		}
+	}
+	return paths;
+}
+
+} // namespace duckdb
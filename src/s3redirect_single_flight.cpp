@@ -0,0 +1,84 @@
+#include "s3redirect_single_flight.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+size_t S3RedirectSingleFlight::FlightKeyHash::operator()(const FlightKey &key) const {
+	auto h = std::hash<string>()(key.object_key);
+	h ^= std::hash<idx_t>()(key.location) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	h ^= std::hash<idx_t>()(key.nr_bytes) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	return h;
+}
+
+S3RedirectSingleFlight::Shard &S3RedirectSingleFlight::GetShard(const FlightKey &key) {
+	return shards[FlightKeyHash()(key) % SHARD_COUNT];
+}
+
+void S3RedirectSingleFlight::Read(const string &object_key, idx_t location, idx_t nr_bytes, data_ptr_t buffer,
+                                  const fetch_function_t &fetch) {
+	FlightKey key {object_key, location, nr_bytes};
+	auto &shard = GetShard(key);
+	shared_ptr<Flight> flight;
+	bool leader = false;
+	{
+		std::lock_guard<std::mutex> lk(shard.lock);
+		auto it = shard.flights.find(key);
+		if (it != shard.flights.end()) {
+			flight = it->second;
+			flight->waiters++;
+		} else {
+			flight = make_shared_ptr<Flight>();
+			shard.flights.emplace(key, flight);
+			leader = true;
+		}
+	}
+
+	if (!leader) {
+		std::unique_lock<std::mutex> lk(flight->lock);
+		flight->finished.wait(lk, [&flight]() { return flight->done; });
+		if (flight->error) {
+			std::rethrow_exception(flight->error);
+		}
+		// The result is immutable once done; the shared_ptr keeps it alive for the copy.
+		lk.unlock();
+		memcpy(buffer, flight->result.get(), nr_bytes);
+		shared.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	leaders.fetch_add(1, std::memory_order_relaxed);
+	std::exception_ptr error;
+	try {
+		fetch(buffer);
+	} catch (...) {
+		error = std::current_exception();
+	}
+	// Close the flight before publishing, so the waiter count is final and late callers start a
+	// new fetch rather than joining one whose result may not be copied for them.
+	idx_t waiters;
+	{
+		std::lock_guard<std::mutex> lk(shard.lock);
+		shard.flights.erase(key);
+		waiters = flight->waiters;
+	}
+	if (waiters > 0) {
+		unsafe_unique_array<data_t> result;
+		if (!error) {
+			result = make_unsafe_uniq_array_uninitialized<data_t>(nr_bytes);
+			memcpy(result.get(), buffer, nr_bytes);
+		}
+		{
+			std::lock_guard<std::mutex> lk(flight->lock);
+			flight->error = error;
+			flight->result = std::move(result);
+			flight->done = true;
+		}
+		flight->finished.notify_all();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,102 @@
+#include "s3redirect_stats.hpp"
+
+namespace duckdb {
+
+void S3RedirectLatencyHistogram::Record(idx_t micros) {
+	idx_t bucket = micros == 0 ? 0 : 64 - idx_t(__builtin_clzll(micros));
+	buckets[MinValue<idx_t>(bucket, BUCKET_COUNT - 1)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void S3RedirectLatencyHistogram::Reset() {
+	// Not atomic as a whole; a record racing with a reset may survive it, which is harmless.
+	for (auto &bucket : buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	count.store(0, std::memory_order_relaxed);
+}
+
+double S3RedirectLatencyHistogram::Percentile(double percentile) const {
+	idx_t snapshot[BUCKET_COUNT];
+	idx_t total = 0;
+	for (idx_t i = 0; i < BUCKET_COUNT; i++) {
+		snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+		total += snapshot[i];
+	}
+	if (total == 0) {
+		return 0;
+	}
+	auto target = double(total) * percentile / 100.0;
+	double seen = 0;
+	for (idx_t i = 0; i < BUCKET_COUNT; i++) {
+		if (snapshot[i] == 0) {
+			continue;
+		}
+		if (seen + double(snapshot[i]) >= target) {
+			double lower = i == 0 ? 0 : double(idx_t(1) << (i - 1));
+			double upper = double(idx_t(1) << i);
+			return lower + (upper - lower) * (target - seen) / double(snapshot[i]);
+		}
+		seen += double(snapshot[i]);
+	}
+	return double(idx_t(1) << (BUCKET_COUNT - 1));
+}
+
+const char *S3RedirectStats::OperationName(Operation operation) {
+	switch (operation) {
+	case Operation::OPEN:
+		return "open";
+	case Operation::RESOLVE:
+		return "resolve";
+	case Operation::POSITIONAL_READ:
+		return "positional_read";
+	case Operation::SEQUENTIAL_READ:
+		return "sequential_read";
+	case Operation::GET:
+		return "get";
+	case Operation::LOCAL_READ:
+		return "local_read";
+	}
+	return "unknown";
+}
+
+vector<S3RedirectStatRow> S3RedirectStats::Snapshot(const counter_list_t &counters, const counter_list_t &gauges) {
+	vector<S3RedirectStatRow> rows;
+	for (idx_t i = 0; i < OPERATION_COUNT; i++) {
+		auto &histogram = latencies[i];
+		rows.push_back({OperationName(static_cast<Operation>(i)), histogram.GetCount(), true,
+		                operation_bytes[i].load(std::memory_order_relaxed), histogram.Percentile(50),
+		                histogram.Percentile(99)});
+	}
+	auto all_counters = counters;
+	all_counters.emplace_back("coalesced_reads", coalesced_reads.load(std::memory_order_relaxed));
+	{
+		std::lock_guard<std::mutex> lk(baseline_lock);
+		for (auto &counter : all_counters) {
+			auto baseline = baselines.find(counter.first);
+			auto base = baseline == baselines.end() ? 0 : baseline->second;
+			// A component that was cleared since the reset can sit below its baseline.
+			auto value = counter.second >= base ? counter.second - base : counter.second;
+			rows.push_back({counter.first, value, false, 0, 0, 0});
+		}
+	}
+	for (auto &gauge : gauges) {
+		rows.push_back({gauge.first, gauge.second, false, 0, 0, 0});
+	}
+	return rows;
+}
+
+void S3RedirectStats::Reset(const counter_list_t &counters) {
+	for (idx_t i = 0; i < OPERATION_COUNT; i++) {
+		latencies[i].Reset();
+		operation_bytes[i].store(0, std::memory_order_relaxed);
+	}
+	std::lock_guard<std::mutex> lk(baseline_lock);
+	baselines.clear();
+	for (auto &counter : counters) {
+		baselines[counter.first] = counter.second;
+	}
+	baselines["coalesced_reads"] = coalesced_reads.load(std::memory_order_relaxed);
+}
+
+} // namespace duckdb
@@ -0,0 +1,119 @@
+#include "s3redirect_task_pool.hpp"
+
+namespace duckdb {
+
+S3RedirectTaskPool::~S3RedirectTaskPool() {
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		shutdown = true;
+	}
+	task_available.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void S3RedirectTaskPool::SetMaxThreads(idx_t max_threads_p) {
+	std::lock_guard<std::mutex> lk(lock);
+	// Existing workers are kept; a lower limit only stops further spawning.
+	max_threads = MaxValue<idx_t>(max_threads_p, 1);
+}
+
+void S3RedirectTaskPool::Schedule(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		queue.push_back(std::move(task));
+		if (idle_workers < queue.size() && workers.size() < max_threads) {
+			workers.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+	task_available.notify_one();
+}
+
+namespace {
+
+struct ParallelForState {
+	explicit ParallelForState(idx_t count_p, const std::function<void(idx_t)> &body_p) : count(count_p), body(body_p) {
+	}
+
+	const idx_t count;
+	// Only dereferenced for claimed indexes, i.e. while the caller is still waiting.
+	const std::function<void(idx_t)> &body;
+	std::atomic<idx_t> next {0};
+	std::mutex lock;
+	std::condition_variable all_done;
+	idx_t completed {0};
+	std::exception_ptr error;
+
+	void Work() {
+		while (true) {
+			auto index = next.fetch_add(1);
+			if (index >= count) {
+				return;
+			}
+			bool failed;
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				failed = bool(error);
+			}
+			std::exception_ptr body_error;
+			if (!failed) {
+				try {
+					body(index);
+				} catch (...) {
+					body_error = std::current_exception();
+				}
+			}
+			std::lock_guard<std::mutex> lk(lock);
+			if (body_error && !error) {
+				error = body_error;
+			}
+			if (++completed == count) {
+				all_done.notify_all();
+			}
+		}
+	}
+};
+
+} // namespace
+
+void S3RedirectTaskPool::ParallelFor(idx_t count, idx_t parallelism, const std::function<void(idx_t)> &body) {
+	if (count == 0) {
+		return;
+	}
+	auto state = make_shared_ptr<ParallelForState>(count, body);
+	auto helpers = MinValue<idx_t>(MaxValue<idx_t>(parallelism, 1), count) - 1;
+	for (idx_t i = 0; i < helpers; i++) {
+		Schedule([state]() { state->Work(); });
+	}
+	state->Work();
+	std::unique_lock<std::mutex> lk(state->lock);
+	state->all_done.wait(lk, [&state]() { return state->completed == state->count; });
+	if (state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
+
+void S3RedirectTaskPool::WorkerLoop() {
+	std::unique_lock<std::mutex> lk(lock);
+	while (true) {
+		idle_workers++;
+		task_available.wait(lk, [this]() { return shutdown || !queue.empty(); });
+		idle_workers--;
+		if (queue.empty()) {
+			// Shutdown with nothing left to run.
+			return;
+		}
+		auto task = std::move(queue.front());
+		queue.pop_front();
+		lk.unlock();
+		try {
+			task();
+		} catch (...) {
+			// Tasks report their own errors; never let one take down the worker.
+		}
+		lk.lock();
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,117 @@
+#include "s3redirect_write_buffer.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+S3RedirectWriteBuffer::S3RedirectWriteBuffer(S3RedirectTaskPool &task_pool_p, write_function_t write_p,
+                                             idx_t buffer_size_p)
+    : task_pool(task_pool_p), write(std::move(write_p)), buffer_size(MaxValue<idx_t>(buffer_size_p, 1)) {
+}
+
+S3RedirectWriteBuffer::~S3RedirectWriteBuffer() {
+	if (!in_flight) {
+		return;
+	}
+	RunFlush(*in_flight, write);
+	std::unique_lock<std::mutex> lk(in_flight->lock);
+	in_flight->done.wait(lk, [this]() { return in_flight->state == FlushState::DONE; });
+}
+
+void S3RedirectWriteBuffer::RunFlush(PendingFlush &flush, const write_function_t &write) {
+	{
+		std::lock_guard<std::mutex> lk(flush.lock);
+		if (flush.state != FlushState::PENDING) {
+			return;
+		}
+		flush.state = FlushState::RUNNING;
+	}
+	std::exception_ptr error;
+	try {
+		write(flush.data.get(), flush.size, flush.location);
+	} catch (...) {
+		error = std::current_exception();
+	}
+	{
+		std::lock_guard<std::mutex> lk(flush.lock);
+		flush.error = error;
+		flush.state = FlushState::DONE;
+	}
+	flush.done.notify_all();
+}
+
+void S3RedirectWriteBuffer::WaitForFlush() {
+	if (!in_flight) {
+		return;
+	}
+	auto flush = std::move(in_flight);
+	in_flight_end = 0;
+	// Not picked up by a worker yet: write it on this thread rather than queue behind others.
+	RunFlush(*flush, write);
+	std::unique_lock<std::mutex> lk(flush->lock);
+	flush->done.wait(lk, [&flush]() { return flush->state == FlushState::DONE; });
+	if (flush->error) {
+		std::rethrow_exception(flush->error);
+	}
+	spare = std::move(flush->data);
+}
+
+void S3RedirectWriteBuffer::SubmitFilling() {
+	if (filling_size == 0) {
+		return;
+	}
+	WaitForFlush();
+	auto flush = make_shared_ptr<PendingFlush>();
+	flush->data = std::move(filling);
+	flush->location = filling_location;
+	flush->size = filling_size;
+	in_flight = flush;
+	in_flight_end = filling_location + filling_size;
+	filling_size = 0;
+	// The task holds only the flush: once the writer has waited for it, a worker that picks it up
+	// late finds it done and never touches this object.
+	auto write_function = &write;
+	task_pool.Schedule([flush, write_function]() { RunFlush(*flush, *write_function); });
+}
+
+void S3RedirectWriteBuffer::Write(const_data_ptr_t data, idx_t nr_bytes, idx_t location) {
+	while (nr_bytes > 0) {
+		if (filling_size > 0 &&
+		    (location != filling_location + filling_size || filling_size == filling_capacity)) {
+			SubmitFilling();
+		}
+		if (filling_size == 0) {
+			if (nr_bytes >= buffer_size) {
+				// Nothing to gather: write it directly once everything before it is out.
+				WaitForFlush();
+				write(data, nr_bytes, location);
+				return;
+			}
+			if (!filling) {
+				filling = spare ? std::move(spare) : make_unsafe_uniq_array_uninitialized<data_t>(buffer_size);
+			}
+			filling_location = location;
+			filling_capacity = buffer_size - location % buffer_size;
+		}
+		auto length = MinValue<idx_t>(nr_bytes, filling_capacity - filling_size);
+		memcpy(filling.get() + filling_size, data, length);
+		filling_size += length;
+		data += length;
+		location += length;
+		nr_bytes -= length;
+	}
+	if (filling_size == filling_capacity) {
+		SubmitFilling();
+	}
+}
+
+void S3RedirectWriteBuffer::Flush() {
+	SubmitFilling();
+	WaitForFlush();
+}
+
+idx_t S3RedirectWriteBuffer::BufferedEnd() const {
+	return MaxValue<idx_t>(in_flight_end, filling_size > 0 ? filling_location + filling_size : 0);
+}
+
+} // namespace duckdb